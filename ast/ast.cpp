@@ -6,8 +6,8 @@
 
 bool is_node_const_func_decl(ASTNode* node)
 {
-	if (auto const_ptr = dynamic_cast<ConstantDeclNode*>(node)) {
-		if (dynamic_cast<Function_T*>(const_ptr->type)) {
+	if (auto const_ptr = node_cast<ConstantDeclNode>(node)) {
+		if (const_ptr->type != nullptr && const_ptr->type->type_class() == TypeClass::Function) {
 			return true;
 		}
 	}
@@ -17,133 +17,160 @@ bool is_node_const_func_decl(ASTNode* node)
 
 bool is_node_variable(ASTNode* node)
 {
-	if (dynamic_cast<VariableDeclNode*>(node)) {
-		return true;
-	}
-
-	return false;
+	return node_cast<VariableDeclNode>(node) != nullptr;
 }
 
 bool is_node_constant(ASTNode* node)
 {
-	if (dynamic_cast<ConstantDeclNode*>(node)) {
-		return true;
-	}
-
-	return false;
+	return node_cast<ConstantDeclNode>(node) != nullptr;
 }
 
-static void _report_type_error(ASTNode* node_a, ASTNode* node_b)
+static void _report_type_error(const LineIndex& lines, ASTNode* node_a, ASTNode* node_b)
 {
-	std::cout << "ERROR(" << node_a->code.line + 1 << ", " << node_a->code.column + 1 << ") Type mismatch between \"" << node_a->code.text << "\" and \"" << node_b->code.text << "\"" << std::endl;
+	SourcePosition pos;
+	if (lines.contains(node_a->code.text.begin()))
+		pos = lines.position(node_a->code.text.begin());
+
+	std::cout << "ERROR(" << pos.line + 1 << ", " << pos.column + 1 << ") Type mismatch between \"" << node_a->code.text << "\" and \"" << node_b->code.text << "\"" << std::endl;
 }
 
-void AST::_link_refs_helper(ASTNode **node_ref, ScopeStack<DeclNode*> *scope_stack)
+namespace {
+
+// Hooks up the nominal type of a declaration to the type it names
+void link_nominal_type(DeclNode* node, ScopeStack<DeclNode*>* scope_stack)
 {
-	ASTNode *_node = *node_ref;
-	if (_node == nullptr) {
-		// TODO: is this even remotely right????
-		// (Ha ha!  Screw you, future us!)
-		return;
+	if (node->type->type_class() == TypeClass::Unknown) {
+		if (scope_stack->is_symbol_in_scope(node->type->symbol)) {
+			node->type = (*scope_stack)[node->type->symbol]->type;
+		}
+		else {
+			// TODO proper error reporting
+			throw std::exception();
+		}
+	}
+}
+
+struct LinkRefsVisitor {
+	MemoryArena<>* store;
+	ScopeStack<DeclNode*>* scope_stack;
+	ASTNode** node_ref; // Where the visited node is referenced from
+
+	template <typename T>
+	void link(T** ref)
+	{
+		link_node(reinterpret_cast<ASTNode**>(ref));
+	}
+
+	void link_node(ASTNode** ref)
+	{
+		if (*ref == nullptr) {
+			// TODO: is this even remotely right????
+			// (Ha ha!  Screw you, future us!)
+			return;
+		}
+
+		LinkRefsVisitor child {store, scope_stack, ref};
+		visit(*ref, child);
 	}
 
-	if (auto node = dynamic_cast<NamespaceNode*>(_node)) {
+	void operator()(NamespaceNode* node)
+	{
 		scope_stack->push_scope();
 
 		for (auto &ns : node->namespaces) {
-			_link_refs_helper(reinterpret_cast<ASTNode**>(&ns), scope_stack);
+			link(&ns);
 		}
 
 		for (auto &decl : node->declarations) {
-			_link_refs_helper(reinterpret_cast<ASTNode**>(&decl), scope_stack);
+			link(&decl);
 		}
 
 		scope_stack->pop_scope();
 	}
-	else if (auto node = dynamic_cast<ScopeNode*>(_node)) {
+
+	void operator()(ScopeNode* node)
+	{
 		scope_stack->push_scope();
 		for (auto &statement : node->statements) {
-			_link_refs_helper(reinterpret_cast<ASTNode**>(&statement), scope_stack);
+			link(&statement);
 		}
 		scope_stack->pop_scope();
 	}
-	else if (auto node = dynamic_cast<FuncLiteralNode*>(_node)) {
+
+	void operator()(FuncLiteralNode* node)
+	{
 		scope_stack->push_scope();
 
 		// Push parameters onto the scope stack
 		for (auto &param : node->parameters) {
-			_link_refs_helper(reinterpret_cast<ASTNode**>(&param), scope_stack);
+			link(&param);
 		}
 
 		// Recurse into body
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->body), scope_stack);
+		node->ensure_body_parsed();
+		link(&node->body);
 
 		scope_stack->pop_scope();
 	}
 
 	//////////////////////////////////
 	// Declarations
-	else if (auto node = dynamic_cast<ConstantDeclNode*>(_node)) {
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->initializer), scope_stack);
-
-		// Hook up nominal types
-		if (node->type->type_class() == TypeClass::Unknown) {
-			if (scope_stack->is_symbol_in_scope(node->type->name)) {
-				node->type = (*scope_stack)[node->type->name]->type;
-			}
-			else {
-				// TODO proper error reporting
-				throw std::exception();
-			}
-		}
-		scope_stack->push_symbol(node->name, node);
+	void operator()(ConstantDeclNode* node)
+	{
+		link(&node->initializer);
+		link_nominal_type(node, scope_stack);
+		scope_stack->push_symbol(node->symbol, node);
 	}
-	else if (auto node = dynamic_cast<VariableDeclNode*>(_node)) {
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->initializer), scope_stack);
 
-		// Hook up nominal types
-		if (node->type->type_class() == TypeClass::Unknown) {
-			if (scope_stack->is_symbol_in_scope(node->type->name)) {
-				node->type = (*scope_stack)[node->type->name]->type;
-			}
-			else {
-				// TODO proper error reporting
-				throw std::exception();
-			}
-		}
-		scope_stack->push_symbol(node->name, node);
+	void operator()(VariableDeclNode* node)
+	{
+		link(&node->initializer);
+		link_nominal_type(node, scope_stack);
+		scope_stack->push_symbol(node->symbol, node);
 	}
-	else if (auto node = dynamic_cast<NominalTypeDeclNode*>(_node)) {
-		scope_stack->push_symbol(node->name, node);
+
+	void operator()(NominalTypeDeclNode* node)
+	{
+		scope_stack->push_symbol(node->symbol, node);
 	}
 
 	//////////////////////////////////
 	// Expressions
-	else if (auto node = dynamic_cast<AddressOfNode*>(_node)) {
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->expr), scope_stack);
+	void operator()(AddressOfNode* node)
+	{
+		link(&node->expr);
 	}
-	else if (auto node = dynamic_cast<DerefNode*>(_node)) {
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->expr), scope_stack);
+
+	void operator()(DerefNode* node)
+	{
+		link(&node->expr);
 	}
-	else if (auto node = dynamic_cast<UnknownIdentifierNode*>(_node)) {
-		if (scope_stack->is_symbol_in_scope(node->code.text)) {
-			DeclNode* entry = (*scope_stack)[node->code.text];
-			if (dynamic_cast<VariableDeclNode*>(entry))
-				*node_ref = this->store.alloc<VariableNode>();
-			else if (dynamic_cast<ConstantDeclNode*>(entry))
-				*node_ref = this->store.alloc<ConstantDeclNode>();
-
-			(*node_ref)->code = _node->code;
-			_link_refs_helper(node_ref, scope_stack);
+
+	void operator()(UnknownIdentifierNode* node)
+	{
+		if (scope_stack->is_symbol_in_scope(node->code.symbol)) {
+			DeclNode* entry = (*scope_stack)[node->code.symbol];
+			if (entry->kind == NodeKind::VariableDecl)
+				*node_ref = store->alloc<VariableNode>();
+			else if (entry->kind == NodeKind::ConstantDecl)
+				*node_ref = store->alloc<ConstantNode>();
+			else
+				// TODO proper error reporting
+				throw std::exception();
+
+			(*node_ref)->code = node->code;
+			link_node(node_ref);
 		}
 		else {
 			// TODO proper error reporting
 			throw std::exception();
 		}
 	}
-	else if (auto node = dynamic_cast<VariableNode*>(_node)) {
-		if (scope_stack->is_symbol_in_scope(node->code.text)) {
-			if (auto decl = dynamic_cast<VariableDeclNode*>((*scope_stack)[node->code.text])) {
+
+	void operator()(VariableNode* node)
+	{
+		if (scope_stack->is_symbol_in_scope(node->code.symbol)) {
+			if (auto decl = node_cast<VariableDeclNode>((*scope_stack)[node->code.symbol])) {
 				node->declaration = decl;
 			}
 			else {
@@ -156,9 +183,11 @@ void AST::_link_refs_helper(ASTNode **node_ref, ScopeStack<DeclNode*> *scope_sta
 			throw std::exception();
 		}
 	}
-	else if (auto node = dynamic_cast<ConstantNode*>(_node)) {
-		if (scope_stack->is_symbol_in_scope(node->code.text)) {
-			if (auto decl = dynamic_cast<ConstantDeclNode*>((*scope_stack)[node->code.text])) {
+
+	void operator()(ConstantNode* node)
+	{
+		if (scope_stack->is_symbol_in_scope(node->code.symbol)) {
+			if (auto decl = node_cast<ConstantDeclNode>((*scope_stack)[node->code.symbol])) {
 				node->declaration = decl;
 			}
 			else {
@@ -171,26 +200,35 @@ void AST::_link_refs_helper(ASTNode **node_ref, ScopeStack<DeclNode*> *scope_sta
 			throw std::exception();
 		}
 	}
-	else if (auto node = dynamic_cast<FuncCallNode*>(_node)) {
+
+	void operator()(FuncCallNode* node)
+	{
 		for (auto &param : node->parameters) {
-			_link_refs_helper(reinterpret_cast<ASTNode**>(&param), scope_stack);
+			link(&param);
 		}
 	}
-	else if (auto node = dynamic_cast<AssignmentNode*>(_node)) {
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->lhs), scope_stack);
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->rhs), scope_stack);
-	}
-	else if (auto node = dynamic_cast<ReturnNode*>(_node)) {
-		_link_refs_helper(reinterpret_cast<ASTNode**>(&node->expression), scope_stack);
-	}
-	else if (dynamic_cast<LiteralNode*>(_node) ||
-	         dynamic_cast<EmptyExprNode*>(_node)) {
-		return;
+
+	void operator()(AssignmentNode* node)
+	{
+		link(&node->lhs);
+		link(&node->rhs);
 	}
-	else {
-		// TODO proper error reporting
-		throw std::exception();
+
+	void operator()(ReturnNode* node)
+	{
+		link(&node->expression);
 	}
+
+	void operator()(LiteralNode*) {}
+	void operator()(EmptyExprNode*) {}
+};
+
+} // namespace
+
+void AST::_link_refs_helper(ASTNode **node_ref, ScopeStack<DeclNode*> *scope_stack)
+{
+	LinkRefsVisitor visitor {&this->store, scope_stack, node_ref};
+	visitor.link_node(node_ref);
 }
 
 void AST::link_references()
@@ -199,23 +237,29 @@ void AST::link_references()
 	_link_refs_helper(reinterpret_cast<ASTNode**>(&this->root), &scope_stack);
 }
 
-static bool _check_types_helper(ASTNode *_node)
-{
-	if (_node == nullptr)
-		return true;
+static bool _check_types_helper(ASTNode *_node, const LineIndex& lines);
+
+namespace {
+
+struct CheckTypesVisitor {
+	const LineIndex& lines;
 
-	if (auto node = dynamic_cast<NamespaceNode*>(_node)) {
+	bool operator()(NamespaceNode* node)
+	{
 		for (auto i : node->namespaces) {
-			if (!_check_types_helper(i))
+			if (!_check_types_helper(i, lines))
 				return false;
 		}
 		for (auto i : node->declarations) {
-			if (!_check_types_helper(i))
+			if (!_check_types_helper(i, lines))
 				return false;
 		}
+		return true;
 	}
-	else if (auto node = dynamic_cast<DeclNode*>(_node)) {
-		if (!_check_types_helper(node->initializer))
+
+	bool operator()(DeclNode* node)
+	{
+		if (!_check_types_helper(node->initializer, lines))
 			return false;
 
 		//TODO Handle this better
@@ -223,46 +267,85 @@ static bool _check_types_helper(ASTNode *_node)
 			return true;
 
 		if (*node->type != *node->initializer->eval_type) {
-			_report_type_error(node, node->initializer);
+			_report_type_error(lines, node, node->initializer);
 			return false;
 		}
+		return true;
 	}
-	else if (auto node = dynamic_cast<ScopeNode*>(_node)) {
+
+	bool operator()(ScopeNode* node)
+	{
 		for (auto i : node->statements) {
-			if (!_check_types_helper(i))
+			if (!_check_types_helper(i, lines))
 				return false;
 		}
+		return true;
 	}
-	else if (auto node = dynamic_cast<ReturnNode*>(_node)) {
-		if (!_check_types_helper(node->expression))
-			return false;
+
+	bool operator()(ReturnNode* node)
+	{
+		return _check_types_helper(node->expression, lines);
 	}
-	else if (auto node = dynamic_cast<VariableNode*>(_node)) {
+
+	bool operator()(VariableNode* node)
+	{
 		//TODO
 		node->eval_type = node->declaration->type; // Propigate type from declaration
+		return true;
 	}
-	else if (auto node = dynamic_cast<ConstantNode*>(_node)) {
+
+	bool operator()(ConstantNode* node)
+	{
 		//TODO
 		node->eval_type = node->declaration->type; // Propigate type from declaration
+		return true;
 	}
-	else if (auto node = dynamic_cast<FuncLiteralNode*>(_node)) {
-		if (!_check_types_helper(node->body))
-			return false;
+
+	bool operator()(FuncLiteralNode* node)
+	{
+		return _check_types_helper(node->ensure_body_parsed(), lines);
 	}
-	else if (auto node = dynamic_cast<FuncCallNode*>(_node)) {
+
+	bool operator()(FuncCallNode*)
+	{
 		//TODO
+		return true;
 	}
-	else if (auto node = dynamic_cast<AssignmentNode*>(_node)) {
+
+	bool operator()(AssignmentNode* node)
+	{
+		if (!_check_types_helper(node->lhs, lines) || !_check_types_helper(node->rhs, lines))
+			return false;
+
+		//TODO Handle this better
+		if (node->lhs->eval_type == nullptr || node->rhs->eval_type == nullptr)
+			return true;
+
 		if (*node->lhs->eval_type != *node->rhs->eval_type) {
-			_report_type_error(node->lhs, node->rhs);
+			_report_type_error(lines, node->lhs, node->rhs);
 			return false;
 		}
+		return true;
+	}
+
+	// Everything else has nothing to check (yet)
+	bool operator()(ASTNode*)
+	{
+		return true;
 	}
+};
+
+} // namespace
 
-	return true;
+static bool _check_types_helper(ASTNode *_node, const LineIndex& lines)
+{
+	if (_node == nullptr)
+		return true;
+
+	return visit(_node, CheckTypesVisitor {lines});
 }
 
 bool AST::check_types()
 {
-	return _check_types_helper(this->root);
-}
\ No newline at end of file
+	return _check_types_helper(this->root, lines);
+}
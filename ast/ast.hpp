@@ -2,9 +2,13 @@
 #define AST_HPP
 
 #include <iostream>
+#include <memory>
+#include <vector>
+#include "line_index.hpp"
 #include "memory_arena.hpp"
 #include "scope_stack.hpp"
 #include "string_slice.hpp"
+#include "symbol_table.hpp"
 #include "tokens.hpp"
 #include "type.hpp"
 
@@ -16,15 +20,13 @@ static void print_indent(int indent)
 }
 
 struct CodeSlice {
-	unsigned int line = 0;
-	unsigned int column = 0;
 	StringSlice text;
+	uint32_t symbol = NO_SYMBOL; // Symbol ID of the token it was assigned from, if any
 
 	CodeSlice& operator=(const Token& token)
 	{
-		line = token.line;
-		column = token.column;
 		text = token.text;
+		symbol = token.symbol;
 
 		return *this;
 	}
@@ -35,12 +37,51 @@ struct CodeSlice {
 ////////////////////////////////////////////////////////////////
 
 /**
- * Base class for nodes in the AST.  Basically just exists to ensure
- * virtual destructor.
+ * The concrete type of an AST node, so that passes can dispatch on it with
+ * a switch instead of trying dynamic_casts one after another.  See visit().
+ */
+enum struct NodeKind {
+	Namespace,
+	Return,
+
+	// Declarations
+	ConstantDecl,
+	VariableDecl,
+	NominalTypeDecl,
+
+	// Expressions
+	Scope,
+	EmptyExpr,
+	AddressOf,
+	Deref,
+	UnknownIdentifier,
+	Variable,
+	Constant,
+	FuncCall,
+	Assignment,
+
+	// Literals
+	IntegerLiteral,
+	FloatLiteral,
+	StringLiteral,
+	FuncLiteral,
+};
+
+
+/**
+ * Base class for nodes in the AST.  Each concrete node type has a KIND,
+ * which its constructor stores in kind.
+ *
+ * Nodes only point into memory owned by the AST, so they must not own
+ * anything themselves: the AST's arena never runs their destructors.
  */
 struct ASTNode {
+	typedef void arena_skips_destructor;
+
+	const NodeKind kind;
 	CodeSlice code;
 
+	explicit ASTNode(NodeKind kind): kind {kind} {}
 	virtual ~ASTNode() {}
 
 	virtual void print(int indent)
@@ -57,6 +98,8 @@ struct ASTNode {
  * Base class for Expression and Declaration nodes.
  */
 struct StatementNode: ASTNode {
+	explicit StatementNode(NodeKind kind): ASTNode(kind) {}
+
 	virtual void print(int indent)
 	{
 		print_indent(indent);
@@ -71,6 +114,8 @@ struct StatementNode: ASTNode {
 struct ExprNode: StatementNode {
 	Type* eval_type = nullptr;  // Type that the expression evaluates to
 
+	explicit ExprNode(NodeKind kind): StatementNode(kind) {}
+
 	virtual void print(int indent) = 0;
 };
 
@@ -80,11 +125,12 @@ struct ExprNode: StatementNode {
  */
 struct DeclNode : StatementNode {
 	StringSlice name;
+	uint32_t symbol = NO_SYMBOL; // Symbol ID of the name
 	Type* type;
 	ExprNode* initializer = nullptr;
 
-	DeclNode() {}
-	DeclNode(StringSlice name, Type* type, ExprNode* init) : name { name }, type { type }, initializer { init } {}
+	explicit DeclNode(NodeKind kind): StatementNode(kind) {}
+	DeclNode(NodeKind kind, StringSlice name, Type* type, ExprNode* init) : StatementNode(kind), name { name }, type { type }, initializer { init } {}
 
 	virtual void print(int indent)
 	{
@@ -98,6 +144,10 @@ struct DeclNode : StatementNode {
  * Namespace node.
  */
 struct NamespaceNode: ASTNode {
+	static const NodeKind KIND = NodeKind::Namespace;
+
+	NamespaceNode(): ASTNode(KIND) {}
+
 	StringSlice name;
 	Slice<NamespaceNode*> namespaces;
 	Slice<DeclNode*> declarations;
@@ -124,6 +174,10 @@ struct NamespaceNode: ASTNode {
  * Scope node.
  */
 struct ScopeNode: ExprNode {
+	static const NodeKind KIND = NodeKind::Scope;
+
+	ScopeNode(): ExprNode(KIND) {}
+
 	Slice<StatementNode*> statements;
 
 	virtual void print(int indent)
@@ -144,6 +198,8 @@ struct ScopeNode: ExprNode {
  * Literal node base class.
  */
 struct LiteralNode: ExprNode {
+	explicit LiteralNode(NodeKind kind): ExprNode(kind) {}
+
 	virtual void print(int indent)
 	{
 		print_indent(indent);
@@ -159,6 +215,10 @@ struct LiteralNode: ExprNode {
 ////////////////////////////////////////////////////////////////
 
 struct ReturnNode: StatementNode {
+	static const NodeKind KIND = NodeKind::Return;
+
+	ReturnNode(): StatementNode(KIND) {}
+
 	ExprNode* expression;
 
 	virtual void print(int indent)
@@ -176,6 +236,10 @@ struct ReturnNode: StatementNode {
 ////////////////////////////////////////////////////////////////
 
 struct ConstantDeclNode: DeclNode {
+	static const NodeKind KIND = NodeKind::ConstantDecl;
+
+	ConstantDeclNode(): DeclNode(KIND) {}
+
 	virtual void print(int indent)
 	{
 		// Name
@@ -197,10 +261,12 @@ struct ConstantDeclNode: DeclNode {
 };
 
 struct VariableDeclNode : DeclNode {
+	static const NodeKind KIND = NodeKind::VariableDecl;
+
 	bool mut;
 
-	VariableDeclNode() {}
-	VariableDeclNode(StringSlice name, Type* type, ExprNode* init, bool mut) : DeclNode(name, type, init), mut { mut } {}
+	VariableDeclNode(): DeclNode(KIND) {}
+	VariableDeclNode(StringSlice name, Type* type, ExprNode* init, bool mut) : DeclNode(KIND, name, type, init), mut { mut } {}
 
 	virtual void print(int indent)
 	{
@@ -226,6 +292,10 @@ struct VariableDeclNode : DeclNode {
 };
 
 struct NominalTypeDeclNode : DeclNode {
+	static const NodeKind KIND = NodeKind::NominalTypeDecl;
+
+	NominalTypeDeclNode(): DeclNode(KIND) {}
+
 	// This Node is for identification and uses "type" from DeclNode
 };
 
@@ -235,7 +305,12 @@ struct NominalTypeDeclNode : DeclNode {
 ////////////////////////////////////////////////////////////////
 
 struct IntegerLiteralNode: LiteralNode {
+	static const NodeKind KIND = NodeKind::IntegerLiteral;
+
+	IntegerLiteralNode(): LiteralNode(KIND) {}
+
 	StringSlice text;
+	uint64_t value; // Decoded by the lexer
 	virtual void print(int indent)
 	{
 		print_indent(indent);
@@ -244,14 +319,72 @@ struct IntegerLiteralNode: LiteralNode {
 };
 
 struct FloatLiteralNode: LiteralNode {
+	static const NodeKind KIND = NodeKind::FloatLiteral;
+
+	FloatLiteralNode(): LiteralNode(KIND) {}
+
 	StringSlice text;
+	double value; // Decoded by the lexer
+	virtual void print(int indent)
+	{
+		print_indent(indent);
+		std::cout << text.to_string();
+	}
 };
 
+struct StringLiteralNode: LiteralNode {
+	static const NodeKind KIND = NodeKind::StringLiteral;
+
+	StringLiteralNode(): LiteralNode(KIND) {}
+
+	StringSlice text;
+	StringSlice value; // Contents with escapes decoded
+	virtual void print(int indent)
+	{
+		print_indent(indent);
+		std::cout << "\"" << text.to_string() << "\"";
+	}
+};
+
+
+struct FuncLiteralNode;
+
+/**
+ * Parses function bodies that the parser skipped over, on demand.  See
+ * FuncLiteralNode::ensure_body_parsed() and parse_tokens_outline().
+ */
+class DeferredBodyParser
+{
+public:
+	virtual ~DeferredBodyParser() {}
+	virtual ScopeNode* parse_body(const FuncLiteralNode& fn) = 0;
+};
 
 struct FuncLiteralNode: LiteralNode {
+	static const NodeKind KIND = NodeKind::FuncLiteral;
+
+	FuncLiteralNode(): LiteralNode(KIND) {}
+
 	Slice<VariableDeclNode*> parameters;
 	Type* return_type;
-	ScopeNode* body;
+	// Mutable so that ensure_body_parsed() works on const nodes too
+	mutable ScopeNode* body = nullptr; // nullptr until parsed, if parsing it was deferred
+
+	// Where a skipped body is, for parsing it later
+	mutable DeferredBodyParser* deferred = nullptr; // Set while the body is still to be parsed
+	uint32_t body_begin = 0; // Token index of the body's "("
+	uint32_t body_end = 0; // Token index just past its ")"
+	uint32_t fns_in_scope = 0; // Number of top-level const functions declared before it
+
+	// Parses the body first if that was deferred
+	ScopeNode* ensure_body_parsed() const
+	{
+		if (deferred != nullptr) {
+			body = deferred->parse_body(*this);
+			deferred = nullptr;
+		}
+		return body;
+	}
 
 	virtual void print(int indent)
 	{
@@ -276,7 +409,13 @@ struct FuncLiteralNode: LiteralNode {
 		// Body
 		print_indent(indent+1);
 		std::cout << "BODY" << std::endl;
-		body->print(indent+1);
+		if (body != nullptr) {
+			body->print(indent+1);
+		}
+		else {
+			print_indent(indent+2);
+			std::cout << "NOT_PARSED";
+		}
 		std::cout << std::endl;
 	}
 };
@@ -287,6 +426,10 @@ struct FuncLiteralNode: LiteralNode {
 ////////////////////////////////////////////////////////////////
 
 struct EmptyExprNode : ExprNode {
+	static const NodeKind KIND = NodeKind::EmptyExpr;
+
+	EmptyExprNode(): ExprNode(KIND) {}
+
 	virtual void print(int indent)
 	{
 		print_indent(indent);
@@ -295,6 +438,10 @@ struct EmptyExprNode : ExprNode {
 };
 
 struct AddressOfNode : ExprNode {
+	static const NodeKind KIND = NodeKind::AddressOf;
+
+	AddressOfNode(): ExprNode(KIND) {}
+
 	ExprNode* expr;
 	virtual void print(int indent)
 	{
@@ -305,6 +452,10 @@ struct AddressOfNode : ExprNode {
 };
 
 struct DerefNode : ExprNode {
+	static const NodeKind KIND = NodeKind::Deref;
+
+	DerefNode(): ExprNode(KIND) {}
+
 	ExprNode* expr;
 	virtual void print(int indent)
 	{
@@ -315,6 +466,10 @@ struct DerefNode : ExprNode {
 };
 
 struct UnknownIdentifierNode : ExprNode {
+	static const NodeKind KIND = NodeKind::UnknownIdentifier;
+
+	UnknownIdentifierNode(): ExprNode(KIND) {}
+
 	virtual void print(int indent)
 	{
 		print_indent(indent);
@@ -323,10 +478,12 @@ struct UnknownIdentifierNode : ExprNode {
 };
 
 struct VariableNode: ExprNode {
+	static const NodeKind KIND = NodeKind::Variable;
+
 	VariableDeclNode* declaration;
 
-	VariableNode() {}
-	VariableNode(VariableDeclNode* decl) : declaration { decl }
+	VariableNode(): ExprNode(KIND) {}
+	VariableNode(VariableDeclNode* decl) : ExprNode(KIND), declaration { decl }
 	{
 		assert(declaration != nullptr);
 
@@ -342,10 +499,12 @@ struct VariableNode: ExprNode {
 };
 
 struct ConstantNode : ExprNode {
+	static const NodeKind KIND = NodeKind::Constant;
+
 	ConstantDeclNode* declaration;
 
-	ConstantNode() {}
-	ConstantNode(ConstantDeclNode* decl) : declaration { decl }
+	ConstantNode(): ExprNode(KIND) {}
+	ConstantNode(ConstantDeclNode* decl) : ExprNode(KIND), declaration { decl }
 	{
 		assert(declaration != nullptr);
 
@@ -361,7 +520,12 @@ struct ConstantNode : ExprNode {
 };
 
 struct FuncCallNode: ExprNode {
+	static const NodeKind KIND = NodeKind::FuncCall;
+
+	FuncCallNode(): ExprNode(KIND) {}
+
 	StringSlice name; //TODO change to declaration pointer
+	uint32_t symbol = NO_SYMBOL; // Symbol ID of the name
 	Slice<ExprNode*> parameters;
 
 	virtual void print(int indent)
@@ -379,6 +543,10 @@ struct FuncCallNode: ExprNode {
 };
 
 struct AssignmentNode: ExprNode {
+	static const NodeKind KIND = NodeKind::Assignment;
+
+	AssignmentNode(): ExprNode(KIND) {}
+
 	ExprNode* lhs;
 	ExprNode* rhs;
 
@@ -394,6 +562,80 @@ struct AssignmentNode: ExprNode {
 };
 
 
+////////////////////////////////////////////////////////////////
+// Dispatch on node kinds
+////////////////////////////////////////////////////////////////
+
+/**
+ * Returns node as a T if it's a T, and nullptr otherwise (or if node is
+ * nullptr).  Only works for the concrete node types, i.e. those with a
+ * KIND.
+ */
+template <typename T>
+T* node_cast(ASTNode* node)
+{
+	return (node != nullptr && node->kind == T::KIND) ? static_cast<T*>(node) : nullptr;
+}
+
+template <typename T>
+const T* node_cast(const ASTNode* node)
+{
+	return (node != nullptr && node->kind == T::KIND) ? static_cast<const T*>(node) : nullptr;
+}
+
+
+/**
+ * Calls visitor with node cast to its concrete type, and returns whatever
+ * that returns.  The visitor is usually a struct with an operator() per
+ * node type it cares about.  Overloads taking base classes (e.g. DeclNode*
+ * or LiteralNode*) catch every node type derived from them that doesn't
+ * have its own overload.
+ *
+ * node must not be nullptr.
+ */
+#define AST_VISIT_CASES(CONST) \
+	case NodeKind::Namespace: return visitor(static_cast<CONST NamespaceNode*>(node)); \
+	case NodeKind::Return: return visitor(static_cast<CONST ReturnNode*>(node)); \
+	case NodeKind::ConstantDecl: return visitor(static_cast<CONST ConstantDeclNode*>(node)); \
+	case NodeKind::VariableDecl: return visitor(static_cast<CONST VariableDeclNode*>(node)); \
+	case NodeKind::NominalTypeDecl: return visitor(static_cast<CONST NominalTypeDeclNode*>(node)); \
+	case NodeKind::Scope: return visitor(static_cast<CONST ScopeNode*>(node)); \
+	case NodeKind::EmptyExpr: return visitor(static_cast<CONST EmptyExprNode*>(node)); \
+	case NodeKind::AddressOf: return visitor(static_cast<CONST AddressOfNode*>(node)); \
+	case NodeKind::Deref: return visitor(static_cast<CONST DerefNode*>(node)); \
+	case NodeKind::UnknownIdentifier: return visitor(static_cast<CONST UnknownIdentifierNode*>(node)); \
+	case NodeKind::Variable: return visitor(static_cast<CONST VariableNode*>(node)); \
+	case NodeKind::Constant: return visitor(static_cast<CONST ConstantNode*>(node)); \
+	case NodeKind::FuncCall: return visitor(static_cast<CONST FuncCallNode*>(node)); \
+	case NodeKind::Assignment: return visitor(static_cast<CONST AssignmentNode*>(node)); \
+	case NodeKind::IntegerLiteral: return visitor(static_cast<CONST IntegerLiteralNode*>(node)); \
+	case NodeKind::FloatLiteral: return visitor(static_cast<CONST FloatLiteralNode*>(node)); \
+	case NodeKind::StringLiteral: return visitor(static_cast<CONST StringLiteralNode*>(node)); \
+	case NodeKind::FuncLiteral: return visitor(static_cast<CONST FuncLiteralNode*>(node));
+
+template <typename Visitor>
+auto visit(ASTNode* node, Visitor&& visitor) -> decltype(visitor(static_cast<NamespaceNode*>(node)))
+{
+	switch (node->kind) {
+		AST_VISIT_CASES()
+	}
+	assert(false && "invalid node kind");
+	return visitor(static_cast<NamespaceNode*>(node));
+}
+
+template <typename Visitor>
+auto visit(const ASTNode* node, Visitor&& visitor) -> decltype(visitor(static_cast<const NamespaceNode*>(node)))
+{
+	switch (node->kind) {
+		AST_VISIT_CASES(const)
+	}
+	assert(false && "invalid node kind");
+	return visitor(static_cast<const NamespaceNode*>(node));
+}
+
+#undef AST_VISIT_CASES
+
+
 ////////////////////////////////////////////////////////////////
 // An AST root
 ////////////////////////////////////////////////////////////////
@@ -402,6 +644,9 @@ class AST
 public:
 	NamespaceNode* root;
 	MemoryArena<> store; // Memory store for nodes
+	std::vector<MemoryArena<>> spliced_stores; // Stores of ASTs parsed separately whose nodes were spliced into this one
+	std::unique_ptr<DeferredBodyParser> deferred_bodies; // Parses function bodies that were skipped, if any
+	LineIndex lines; // For finding the line and column of nodes' code in diagnostics
 
 	void print()
 	{
@@ -412,7 +657,7 @@ public:
 	bool check_types();
 
 private:
-	void AST::_link_refs_helper(ASTNode **node_ref, ScopeStack<DeclNode*> *scope_stack);
+	void _link_refs_helper(ASTNode **node_ref, ScopeStack<DeclNode*> *scope_stack);
 };
 
 
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include "ast.hpp"
+#include "diagnostics.hpp"
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+namespace {
+
+// Names the visited node by the most specific overload that catches it
+struct NameVisitor {
+	const char* operator()(const NamespaceNode*) { return "namespace"; }
+	const char* operator()(const ConstantDeclNode*) { return "constant decl"; }
+	const char* operator()(const DeclNode*) { return "decl"; }
+	const char* operator()(const IntegerLiteralNode*) { return "integer"; }
+	const char* operator()(const LiteralNode*) { return "literal"; }
+	const char* operator()(const ASTNode*) { return "node"; }
+};
+
+} // namespace
+
+
+TEST_CASE("Nodes store their kind", "[ast]")
+{
+	FuncCallNode call;
+	VariableDeclNode var;
+	StringLiteralNode str;
+
+	REQUIRE(call.kind == NodeKind::FuncCall);
+	REQUIRE(var.kind == NodeKind::VariableDecl);
+	REQUIRE(str.kind == NodeKind::StringLiteral);
+}
+
+
+TEST_CASE("node_cast() only casts to the node's own type", "[ast]")
+{
+	FuncLiteralNode fn;
+	ExprNode* e = &fn;
+
+	REQUIRE(node_cast<FuncLiteralNode>(e) == &fn);
+	REQUIRE(node_cast<FuncCallNode>(e) == nullptr);
+	REQUIRE(node_cast<FuncLiteralNode>(static_cast<ExprNode*>(nullptr)) == nullptr);
+}
+
+
+TEST_CASE("visit() picks the most specific overload", "[ast]")
+{
+	NamespaceNode ns;
+	ConstantDeclNode constant;
+	VariableDeclNode var;
+	IntegerLiteralNode integer;
+	FloatLiteralNode flt;
+	ReturnNode ret;
+
+	REQUIRE(std::string(visit(static_cast<const ASTNode*>(&ns), NameVisitor())) == "namespace");
+	REQUIRE(std::string(visit(static_cast<const ASTNode*>(&constant), NameVisitor())) == "constant decl");
+	REQUIRE(std::string(visit(static_cast<const ASTNode*>(&var), NameVisitor())) == "decl");
+	REQUIRE(std::string(visit(static_cast<const ASTNode*>(&integer), NameVisitor())) == "integer");
+	REQUIRE(std::string(visit(static_cast<const ASTNode*>(&flt), NameVisitor())) == "literal");
+	REQUIRE(std::string(visit(static_cast<const ASTNode*>(&ret), NameVisitor())) == "node");
+}
+
+
+TEST_CASE("link_references() resolves identifiers", "[ast]")
+{
+	const std::string input = "fn f[x: i32] -> i32 (\n\tval y: i32 = x\n\treturn y\n)\n";
+	DiagnosticEngine diagnostics;
+	const TokenBuffer buffer(input, diagnostics);
+	TokenStream tokens(buffer);
+	AST ast = parse_tokens(tokens, diagnostics);
+	REQUIRE(!diagnostics.has_errors());
+
+	ast.link_references();
+
+	auto fn = node_cast<FuncLiteralNode>(ast.root->declarations[0]->initializer);
+	REQUIRE(fn != nullptr);
+	auto y = node_cast<VariableDeclNode>(fn->body->statements[0]);
+	REQUIRE(y != nullptr);
+	auto x = node_cast<VariableNode>(y->initializer);
+	REQUIRE(x != nullptr);
+	REQUIRE(x->declaration == fn->parameters[0]);
+
+	auto ret = node_cast<ReturnNode>(fn->body->statements[1]);
+	REQUIRE(ret != nullptr);
+	auto y_ref = node_cast<VariableNode>(ret->expression);
+	REQUIRE(y_ref != nullptr);
+	REQUIRE(y_ref->declaration == y);
+}
@@ -1,12 +1,12 @@
-#include <map>
 #include <memory>
-#include <string>
+#include <unordered_map>
 
 #include "ast.hpp"
 #include "slice.hpp"
 #include "builtins.hpp"
+#include "symbol_table.hpp"
 
-std::map<std::string, std::unique_ptr<ConstantDeclNode>> builtins_map;
+std::unordered_map<uint32_t, std::unique_ptr<ConstantDeclNode>> builtins_map; // Keyed by symbol ID
 
 Void_T void_t;
 Byte_T byte;
@@ -30,18 +30,20 @@ void InitBuiltins()
 
 	auto node = new ConstantDeclNode();
 	node->name = "cmalloc";
+	node->symbol = global_symbols().intern(node->name);
 	node->type = &cmalloc_T;
-	builtins_map.insert(std::make_pair("cmalloc", std::unique_ptr<ConstantDeclNode>(node)));
+	builtins_map.insert(std::make_pair(node->symbol, std::unique_ptr<ConstantDeclNode>(node)));
 
 	node = new ConstantDeclNode();
 	node->name = "cfree";
+	node->symbol = global_symbols().intern(node->name);
 	node->type = &cfree_T;
-	builtins_map.insert(std::make_pair("cfree", std::unique_ptr<ConstantDeclNode>(node)));
+	builtins_map.insert(std::make_pair(node->symbol, std::unique_ptr<ConstantDeclNode>(node)));
 }
 
-ConstantDeclNode* GetBuiltin(StringSlice name)
+ConstantDeclNode* GetBuiltin(uint32_t symbol)
 {
-	auto it = builtins_map.find(name.to_string());
+	auto it = builtins_map.find(symbol);
 
 	if (it == builtins_map.end())
 		return nullptr;
@@ -1,6 +1,6 @@
-#include "string_slice.hpp"
+#include <cstdint>
 
 struct ConstantDeclNode;
 
 void InitBuiltins();
-ConstantDeclNode* GetBuiltin(StringSlice name);
\ No newline at end of file
+ConstantDeclNode* GetBuiltin(uint32_t symbol);
\ No newline at end of file
@@ -45,6 +45,7 @@ enum struct TypeClass {
  */
 struct Type {
 	StringSlice name;
+	uint32_t symbol = 0; // Symbol ID of the name, NO_SYMBOL if it has none
 	virtual TypeClass type_class() const = 0;
 	virtual void print(int indent)
 	{
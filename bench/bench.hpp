@@ -0,0 +1,107 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+/**
+ * A tiny benchmark harness.
+ *
+ * Benchmarks are defined in *_bench.cpp files next to the code they
+ * measure, with the BENCHMARK() macro.  They're all compiled into a single
+ * "benchmarks" executable, which runs every benchmark whose name contains
+ * the first command line argument (or all of them if there isn't one).
+ *
+ * Note that the build defaults to unoptimized debug builds, so for
+ * meaningful numbers configure with e.g. -DCMAKE_CXX_FLAGS=-O2.
+ */
+
+typedef void (*BenchmarkFunc)();
+
+struct BenchmarkEntry {
+	const char* name;
+	BenchmarkFunc func;
+};
+
+inline std::vector<BenchmarkEntry>& benchmark_registry()
+{
+	static std::vector<BenchmarkEntry> registry;
+	return registry;
+}
+
+struct BenchmarkRegistrar {
+	BenchmarkRegistrar(const char* name, BenchmarkFunc func)
+	{
+		benchmark_registry().push_back(BenchmarkEntry {name, func});
+	}
+};
+
+#define BENCH_CONCAT_(a, b) a ## b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(name) \
+	static void BENCH_CONCAT(bench_func_, __LINE__)(); \
+	static BenchmarkRegistrar BENCH_CONCAT(bench_registrar_, __LINE__)(name, BENCH_CONCAT(bench_func_, __LINE__)); \
+	static void BENCH_CONCAT(bench_func_, __LINE__)()
+
+
+/**
+ * Simple wall-clock stopwatch.
+ */
+class BenchTimer
+{
+	std::chrono::steady_clock::time_point start_time;
+
+public:
+	BenchTimer(): start_time {std::chrono::steady_clock::now()}
+	{}
+
+	void reset()
+	{
+		start_time = std::chrono::steady_clock::now();
+	}
+
+	// Returns the elapsed time in seconds
+	double elapsed() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	}
+};
+
+
+/**
+ * Runs func repeatedly until at least min_seconds have passed, and returns
+ * the best (smallest) time in seconds of a single run.
+ */
+template <typename F>
+double bench_best_time(F func, double min_seconds = 0.5)
+{
+	double best = 1.0e300;
+	BenchTimer total;
+	do {
+		BenchTimer t;
+		func();
+		const double e = t.elapsed();
+		if (e < best)
+			best = e;
+	}
+	while (total.elapsed() < min_seconds);
+
+	return best;
+}
+
+
+// Prints a throughput measurement in MB/s
+static inline void bench_report_throughput(const char* label, size_t bytes, double seconds)
+{
+	std::printf("    %-40s %10.2f MB/s  (%.3f ms)\n", label, (bytes / (1024.0 * 1024.0)) / seconds, seconds * 1000.0);
+}
+
+
+// Prints a measurement in operations per second
+static inline void bench_report_rate(const char* label, size_t ops, double seconds)
+{
+	std::printf("    %-40s %10.2f Mop/s  (%.3f ms)\n", label, (ops / 1.0e6) / seconds, seconds * 1000.0);
+}
+
+#endif // BENCH_HPP
@@ -0,0 +1,21 @@
+// This file defines the main benchmark function
+
+#include <cstdio>
+#include <cstring>
+
+#include "bench.hpp"
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+
+	for (const auto& b: benchmark_registry()) {
+		if (std::strstr(b.name, filter) == nullptr)
+			continue;
+
+		std::printf("%s\n", b.name);
+		b.func();
+	}
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <string>
+#include <sstream>
+
+/**
+ * Generates a synthetic Rune source file of roughly target_bytes bytes,
+ * for use in benchmarks.
+ *
+ * The output is made up of many small, similar functions with long
+ * comment blocks and generated identifiers, which is representative of
+ * the machine-generated sources we care most about.  If
+ * with_string_literals is true, string literals are sprinkled in as well
+ * (these aren't yet accepted by every compiler stage).
+ */
+static inline std::string generate_corpus(size_t target_bytes, bool with_string_literals = false)
+{
+	std::ostringstream out;
+	size_t i = 0;
+
+	while (static_cast<size_t>(out.tellp()) < target_bytes) {
+		out << "#: Generated function number " << i << ", which adds some numbers\n";
+		out << "#: together and then calls another generated function.\n";
+		out << "# Regular comment explaining something that nobody will read.\n";
+		out << "fn generated_function_" << i << "[first_parameter: i32, second_parameter: i32] -> i32 (\n";
+		out << "\tval local_value_" << i << ": i32 = first_parameter + second_parameter * 42\n";
+		out << "\tvar another_local_value: i64 = (first_parameter << 3) // 7\n";
+		if (with_string_literals) {
+			out << "\tval message = \"Function " << i << " says \\\"hello\\\"\\n\"\n";
+			out << "\tval raw_message = '\"A raw string with \"quotes\" in it\"'\n";
+		}
+		out << "\tanother_local_value = another_local_value + 1000 * local_value_" << i << "\n";
+		out << "\treturn generated_function_" << i << "[local_value_" << i << ", 3]\n";
+		out << ")\n\n";
+		++i;
+	}
+
+	return out.str();
+}
+
+#endif // CORPUS_HPP
@@ -1,3 +1,6 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
 
 #include "c_gen.hpp"
@@ -131,41 +134,84 @@ static void gen_c_type(const Type* t, std::ostream& f)
 	}
 }
 
-static void gen_c_literal(const LiteralNode* literal, std::ostream& f)
-{
-	if (const IntegerLiteralNode* node = dynamic_cast<const IntegerLiteralNode*>(literal)) {
-		f << node->text;
+static void gen_c_expression(const ExprNode* expression, std::ostream& f);
+
+namespace {
+
+struct GenCExpression {
+	std::ostream& f;
+
+	void operator()(const IntegerLiteralNode* node)
+	{
+		// Emit the decoded value, since C doesn't know about 0b or
+		// underscores
+		f << node->value;
+		if (node->value > INT64_MAX)
+			f << "ULL";
 	}
-	else {
-		throw UnreachableException();
+
+	void operator()(const FloatLiteralNode* node)
+	{
+		// Enough digits to round-trip, and always recognizable as a float
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.17g", node->value);
+		f << buf;
+		if (std::strpbrk(buf, ".e") == nullptr)
+			f << ".0";
 	}
-}
 
-static void gen_c_expression(const ExprNode* expression, std::ostream& f)
-{
-	if (const LiteralNode* node = dynamic_cast<const LiteralNode*>(expression)) {
-		gen_c_literal(node, f);
+	void operator()(const StringLiteralNode* node)
+	{
+		f << '"';
+		for (unsigned char c: node->value) {
+			if (c == '"' || c == '\\') {
+				f << '\\' << c;
+			}
+			else if (c < 0x20 || c >= 0x7F) {
+				// Octal escapes are always exactly three digits, so they
+				// can't run into the next character the way \x can
+				char buf[8];
+				std::snprintf(buf, sizeof(buf), "\\%03o", c);
+				f << buf;
+			}
+			else {
+				f << c;
+			}
+		}
+		f << '"';
 	}
-	else if (const DerefNode* node = dynamic_cast<const DerefNode*>(expression)) {
+
+	void operator()(const DerefNode* node)
+	{
 		f << "*";
 		gen_c_expression(node->expr, f);
 	}
-	else if (const AddressOfNode* node = dynamic_cast<const AddressOfNode*>(expression)) {
+
+	void operator()(const AddressOfNode* node)
+	{
 		f << "&";
 		gen_c_expression(node->expr, f);
 	}
-	else if (const VariableNode* node = dynamic_cast<const VariableNode*>(expression)) {
+
+	void operator()(const VariableNode* node)
+	{
 		f << node->declaration->name;
 	}
-	else if (const ConstantNode* node = dynamic_cast<const ConstantNode*>(expression)) {
+
+	void operator()(const ConstantNode* node)
+	{
 		f << node->declaration->name;
 	}
-	else if (const AssignmentNode* node = dynamic_cast<const AssignmentNode*>(expression)) {
+
+	void operator()(const AssignmentNode* node)
+	{
 		gen_c_expression(node->lhs, f);
 		f << " = ";
 		gen_c_expression(node->rhs, f);
 	}
-	else if (const FuncCallNode* node = dynamic_cast<const FuncCallNode*>(expression)) {
+
+	void operator()(const FuncCallNode* node)
+	{
 		if (node->name == "+" && node->parameters.size() == 2) {
 			f << "(";
 			gen_c_expression(node->parameters[0], f);
@@ -173,7 +219,7 @@ static void gen_c_expression(const ExprNode* expression, std::ostream& f)
 			gen_c_expression(node->parameters[1], f);
 			f << ")";
 		}
-		else if (GetBuiltin(node->name) != nullptr) {
+		else if (GetBuiltin(node->symbol) != nullptr) {
 			if (node->name == "cmalloc") {
 				f << "malloc(";
 				gen_c_expression(node->parameters[0], f);
@@ -198,26 +244,49 @@ static void gen_c_expression(const ExprNode* expression, std::ostream& f)
 			f << ")";
 		}
 	}
-	else {
+
+	// Function literals, scopes, etc. can't be expressions in C
+	void operator()(const ASTNode*)
+	{
 		throw UnreachableException();
 	}
-}
+};
 
-static void gen_c_statement(const StatementNode* statement, std::ostream& f)
-{
-	if (const ReturnNode* node = dynamic_cast<const ReturnNode*>(statement)) {
+struct GenCStatement {
+	std::ostream& f;
+
+	void operator()(const ReturnNode* node)
+	{
 		f << "return ";
 		gen_c_expression(node->expression, f);
 	}
-	else if (auto node = dynamic_cast<const DeclNode*>(statement)) {
+
+	void operator()(const DeclNode* node)
+	{
 		gen_c_decl(node, f);
 	}
-	else if (auto node = dynamic_cast<const ExprNode*>(statement)) {
+
+	void operator()(const ExprNode* node)
+	{
 		gen_c_expression(node, f);
 	}
-	else {
+
+	void operator()(const NamespaceNode*)
+	{
 		throw UnreachableException();
 	}
+};
+
+} // namespace
+
+static void gen_c_expression(const ExprNode* expression, std::ostream& f)
+{
+	visit(expression, GenCExpression {f});
+}
+
+static void gen_c_statement(const StatementNode* statement, std::ostream& f)
+{
+	visit(statement, GenCStatement {f});
 
 	f<< ";\n";
 }
@@ -225,11 +294,9 @@ static void gen_c_statement(const StatementNode* statement, std::ostream& f)
 static void gen_c_decl(const DeclNode* decl, std::ostream& f)
 {
 	// Function
-	if (dynamic_cast<const FuncLiteralNode*>(decl->initializer)) {
-		const auto fn = dynamic_cast<const FuncLiteralNode*>(decl->initializer);
-
+	if (const auto fn = node_cast<FuncLiteralNode>(decl->initializer)) {
 		// Constant
-		if (dynamic_cast<const ConstantDeclNode*>(decl)) {
+		if (decl->kind == NodeKind::ConstantDecl) {
 
 			// Return Type
 			gen_c_type(fn->return_type, f);
@@ -257,7 +324,7 @@ static void gen_c_decl(const DeclNode* decl, std::ostream& f)
 
 			// Body
 			f << " {\n";
-			for (auto& s: fn->body->statements)
+			for (auto& s: fn->ensure_body_parsed()->statements)
 				gen_c_statement(s, f);
 			f << "}";
 		}
@@ -265,22 +332,22 @@ static void gen_c_decl(const DeclNode* decl, std::ostream& f)
 		else {
 		}
 	}
-	else if (const VariableDeclNode* node = dynamic_cast<const VariableDeclNode*>(decl)) {
+	else if (const VariableDeclNode* node = node_cast<VariableDeclNode>(decl)) {
 		gen_c_type(node->type, f);
 		f << " " << node->name;
-		if (!dynamic_cast<const EmptyExprNode*>(node->initializer)) {
+		if (node_cast<EmptyExprNode>(node->initializer) == nullptr) {
 			f << " = ";
 			gen_c_expression(node->initializer, f);
 		}
 	}
-	else if (const ConstantDeclNode* node = dynamic_cast<const ConstantDeclNode*>(decl)) {
+	else if (const ConstantDeclNode* node = node_cast<ConstantDeclNode>(decl)) {
 		f << "const ";
 		gen_c_type(node->type, f);
 		f << " " << node->name;
 		f << " = ";
 		gen_c_expression(node->initializer, f);
 	}
-	else if (const NominalTypeDeclNode* node = dynamic_cast<const NominalTypeDeclNode*>(decl)) {
+	else if (const NominalTypeDeclNode* node = node_cast<NominalTypeDeclNode>(decl)) {
 		if (auto type = dynamic_cast<Struct_T*>(node->type)) {
 			f << "typedef struct ";
 			f << node->name;
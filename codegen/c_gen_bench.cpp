@@ -0,0 +1,89 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "ast.hpp"
+#include "builtins.hpp"
+#include "c_gen.hpp"
+#include "diagnostics.hpp"
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+// Functions using everything that the passes after parsing currently
+// handle: locals, pointers, builtins, assignments and calls.
+static std::string generate_pipeline_input(size_t function_count)
+{
+	std::string s;
+	for (size_t f = 0; f < function_count; ++f) {
+		const std::string n = std::to_string(f);
+		s += "fn function_" + n + "[x: i32, y: i32] -> i32 (\n";
+		s += "\tval d: i32 = 42\n";
+		s += "\tval ptr: @i32 = @d\n";
+		s += "\tval mem: @i32 = cmalloc[4]\n";
+		s += "\t$mem = x + y * d - x // 3\n";
+		s += "\tval b: i32 = $mem + d\n";
+		s += "\tcfree[mem]\n";
+		s += "\treturn function_" + n + "[$ptr, b]\n";
+		s += ")\n\n";
+	}
+	return s;
+}
+
+
+BENCHMARK("pipeline: lex, parse, link_references(), check_types() and gen_c_code()")
+{
+	InitBuiltins();
+
+	const std::string input = generate_pipeline_input(20000);
+
+	// Every run starts from the source text, so that each pass sees a
+	// freshly parsed AST.  The split between the stages is from the
+	// fastest run.
+	double stages[5] = {};
+	double best = 1.0e300;
+	std::ostringstream out;
+	bench_best_time([&]() {
+		double times[5];
+		BenchTimer total;
+		BenchTimer t;
+
+		const TokenBuffer buffer(input);
+		times[0] = t.elapsed();
+
+		t.reset();
+		DiagnosticEngine diagnostics;
+		TokenStream tokens(buffer);
+		AST ast = parse_tokens(tokens, diagnostics);
+		times[1] = t.elapsed();
+
+		t.reset();
+		ast.link_references();
+		times[2] = t.elapsed();
+
+		t.reset();
+		ast.check_types();
+		times[3] = t.elapsed();
+
+		t.reset();
+		out.str("");
+		gen_c_code(ast, out);
+		times[4] = t.elapsed();
+
+		const double e = total.elapsed();
+		if (e < best) {
+			best = e;
+			std::copy(times, times + 5, stages);
+		}
+	});
+
+	bench_report_throughput("whole pipeline", input.size(), best);
+	bench_report_throughput("  lex", input.size(), stages[0]);
+	bench_report_throughput("  parse", input.size(), stages[1]);
+	bench_report_throughput("  link_references()", input.size(), stages[2]);
+	bench_report_throughput("  check_types()", input.size(), stages[3]);
+	bench_report_throughput("  gen_c_code()", input.size(), stages[4]);
+}
@@ -1,495 +1,513 @@
 #include "lexer.hpp"
+#include "lexer_literals.hpp"
+#include "lexer_scan.hpp"
 #include "lexer_utils.hpp"
 #include "tokens.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 
 
-void check_for_keyword(Token& token);
-
-class Lexer
+Token Lexer::lex_token()
 {
-	std::string::const_iterator str_iter;
-	std::string::const_iterator str_iter_end;
-	unsigned int line_number = 0;
-	unsigned int column_number = 0;
-	std::string cur_c = "";
-	TokenType last_token_type = UNKNOWN;
-	Token token;
+start_over:
 
-	std::vector<bool> generic_stack = {false};
+	// Get past any whitespace
+	skip_to(scan.whitespace(cur, end));
 
+	// Initialize for new token
+	init_token();
+	token_start = cur;
+	token_unterminated = false;
 
-public:
-	Lexer(const std::string::const_iterator& str_iter, const std::string::const_iterator& str_iter_end): str_iter {str_iter}, str_iter_end {str_iter_end}
-	{
-		cur_utf8(&cur_c, str_iter, str_iter_end);
+	// If it's a comment
+	if (is_comment_char(cur_byte())) {
+		if (!lex_comment())
+			goto start_over;
 	}
 
+	// If it's a string literal
+	else if (cur_byte() == '"' || cur_byte() == '\'') {
+		lex_string_literal();
+	}
 
-	/**
-	 * Lexes and returns a single token.
-	 *
-	 * Always leaves the iterator on the last unconsumed character.
-	 */
-	Token lex_token()
-	{
-start_over:
+	// If it's a number literal
+	else if (is_digit_char(cur_byte())) {
+		lex_number_literal();
+	}
 
-		// Get past any whitespace
-		while (is_ws_char(cur_c)) {
+	// If it's an identifier
+	else if (at_ident_char()) {
+		// The scan kernel only skips the common identifier characters,
+		// so keep going until we hit a real non-identifier character.
+		while (at_ident_char()) {
 			next_char();
+			skip_to(scan.identifier(cur, end));
 		}
 
-		// Initialize for new token
-		init_token();
+		token.text.set_end(cur);
+		token.type = IDENTIFIER;
 
-		// If it's a comment
-		if (is_comment_char(cur_c)) {
-			if (!lex_comment())
-				goto start_over;
-		}
-
-		// If it's a string literal
-		else if (cur_c == "\"" || cur_c == "'") {
-			lex_string_literal();
-		}
-
-		// If it's a number literal
-		else if (is_digit_char(cur_c)) {
-			lex_number_literal();
-		}
-
-		// If it's an identifier
-		else if (is_ident_char(cur_c) && !is_digit_char(cur_c)) {
-			do {
-				next_char();
-			}
-			while (is_ident_char(cur_c));
+		// Check if the identifier is actually a
+		// keyword, and if so update accordingly
+		check_for_keyword(token);
+		if (token.type == IDENTIFIER)
+			token.symbol = symbols->intern(token.text);
+	}
 
-			token.text.set_end(str_iter);
-			token.type = IDENTIFIER;
+	else if (cur_byte() == '>' && in_generic()) {
+		pop_generic(true);
+		next_char();
 
-			// Check if the identifier is actually a
-			// keyword, and if so update accordingly
-			check_for_keyword(token);
-		}
+		token.text.set_end(cur);
+		token.type = RGENERIC;
+	}
 
-		else if (in_generic() && cur_c[0] == '>') {
-			pop_generic(true);
+	// If it's an operator
+	else if (is_op_char(cur_byte())) {
+		do {
 			next_char();
-
-			token.text.set_end(str_iter);
-			token.type = RGENERIC;
-		}
-
-		// If it's an operator
-		else if (is_op_char(cur_c)) {
-			do {
-				next_char();
-			}
-			while (is_op_char(cur_c));
-
-			token.text.set_end(str_iter);
-			token.type = OPERATOR;
 		}
+		while (is_op_char(cur_byte()));
 
-		// If it's a reserved character
-		else if (is_reserved_char(cur_c)) {
-			switch (cur_c[0]) {
-				case '(':
-					token.type = LPAREN;
-					push_generic(false);
-					next_char();
-					break;
-				case ')':
-					token.type = RPAREN;
-					pop_generic(false);
-					next_char();
-					break;
-				case '[':
-					token.type = LSQUARE;
-					push_generic(false);
-					next_char();
-					break;
-				case ']':
-					token.type = RSQUARE;
-					pop_generic(false);
-					next_char();
-					break;
-				case '{':
-					token.type = LCURLY;
-					push_generic(false);
-					next_char();
-					break;
-				case '}':
-					token.type = RCURLY;
-					pop_generic(false);
-					next_char();
-					break;
-				case '@':
-					token.type = AT;
-					next_char();
-					break;
-				case ',':
-					token.type = COMMA;
-					next_char();
-					break;
-				case '.':
-					token.type = PERIOD;
-					next_char();
-					break;
-				case ':':
-					token.type = COLON;
-					next_char();
-					break;
-				case '$':
-					token.type = DOLLAR;
-					next_char();
-					break;
-				case '`': {
-					next_char();
-					if (cur_c[0] == '<') {
-						token.type = LGENERIC;
-						push_generic(true);
-						next_char();
-					}
-					else {
-						token.type = BACKTICK;
-					}
-					break;
-				}
-				default:
-					token.type = RESERVED;
-					next_char();
-					break;
-			}
-
-			token.text.set_end(str_iter);
-		}
+		token.text.set_end(cur);
+		token.type = OPERATOR;
+		token.symbol = symbols->intern(token.text);
+	}
 
-		// If it's a newline
-		else if (is_nl_char(cur_c)) {
-			// Consume all subsequent whitespace and newlines,
-			// so that multiple newlines in a row end up as a single
-			// newline token.  Also escape newlines with a trailing backslash
-			while (is_nl_char(cur_c)) {
+	// If it's a reserved character
+	else if (is_reserved_char(cur_byte())) {
+		switch (cur_byte()) {
+			case '(':
+				token.type = LPAREN;
+				push_generic(false);
 				next_char();
-				while (is_ws_char(cur_c))
-					next_char();
-
-				if (cur_c == "\\") {
+				break;
+			case ')':
+				token.type = RPAREN;
+				pop_generic(false);
+				next_char();
+				break;
+			case '[':
+				token.type = LSQUARE;
+				push_generic(false);
+				next_char();
+				break;
+			case ']':
+				token.type = RSQUARE;
+				pop_generic(false);
+				next_char();
+				break;
+			case '{':
+				token.type = LCURLY;
+				push_generic(false);
+				next_char();
+				break;
+			case '}':
+				token.type = RCURLY;
+				pop_generic(false);
+				next_char();
+				break;
+			case '@':
+				token.type = AT;
+				next_char();
+				break;
+			case ',':
+				token.type = COMMA;
+				next_char();
+				break;
+			case '.':
+				token.type = PERIOD;
+				next_char();
+				break;
+			case ':':
+				token.type = COLON;
+				next_char();
+				break;
+			case '$':
+				token.type = DOLLAR;
+				next_char();
+				break;
+			case '`': {
+				next_char();
+				if (cur_byte() == '<') {
+					token.type = LGENERIC;
+					push_generic(true);
 					next_char();
-					goto start_over;
 				}
+				else {
+					token.type = BACKTICK;
+				}
+				break;
 			}
-
-			if (last_token_type == NEWLINE)
-				goto start_over;
-
-			token.type = NEWLINE;
-		}
-
-		// If it's anything else
-		else if (cur_c != "") {
-			next_char();
-
-			token.text.set_end(str_iter);
-			token.type = UNKNOWN;
-		}
-
-		// EOF
-		else {
-			token.type = LEX_EOF;
+			default:
+				token.type = RESERVED;
+				next_char();
+				break;
 		}
 
-		last_token_type = token.type;
-		return token;
+		token.text.set_end(cur);
 	}
 
+	// If it's a newline
+	else if (is_nl_char(cur_byte())) {
+		// Consume all subsequent whitespace and newlines,
+		// so that multiple newlines in a row end up as a single
+		// newline token.  Also escape newlines with a trailing backslash
+		while (is_nl_char(cur_byte())) {
+			next_char();
+			skip_to(scan.whitespace(cur, end));
 
-private:
-	void next_char()
-	{
-		if (cur_c == "\n") {
-			++line_number;
-			column_number = 0;
-		}
-		else {
-			column_number += cur_c.size();
+			if (cur_byte() == '\\') {
+				next_char();
+				goto start_over;
+			}
 		}
 
-		str_iter += cur_c.size();
-		cur_utf8(&cur_c, str_iter, str_iter_end);
-	}
+		if (last_token_type == NEWLINE)
+			goto start_over;
 
-	void init_token()
-	{
-		token.type = UNKNOWN;
-		token.line = line_number;
-		token.column = column_number;
-		token.text.set_begin(str_iter);
-		token.text.set_end(str_iter);
+		token.type = NEWLINE;
 	}
 
+	// If it's anything else
+	else if (!at_end()) {
+		next_char();
 
-	// Some utility functions for lexing generic delimeters properly
-	void push_generic(bool state)
-	{
-		generic_stack.push_back(state);
-	}
-
-	void pop_generic(bool state)
-	{
-		if (generic_stack.size() > 0 && generic_stack.back() == state)
-			generic_stack.pop_back();
+		token.text.set_end(cur);
+		token.type = UNKNOWN;
 	}
 
-	bool in_generic()
-	{
-		if (generic_stack.size() > 0)
-			return generic_stack.back();
-		else
-			return false;
+	// EOF
+	else {
+		token.type = LEX_EOF;
 	}
 
+	last_token_type = token.type;
+	return token;
+}
 
-	void lex_string_literal()
-	{
-		// Basic string literal
-		if (cur_c == "\"") {
-			next_char();
-			init_token(); // Start the token after the opening quote
-
-			while (cur_c != "\"" && cur_c != "") {
-				// Escape sequence, advance one more character
-				if (cur_c == "\\") {
-					next_char();
-				}
 
+void Lexer::lex_string_literal()
+{
+	// Basic string literal
+	if (cur_byte() == '"') {
+		next_char();
+		init_token(); // Start the token after the opening quote
+
+		skip_to(scan.string(cur, end));
+		while (cur_byte() != '"' && !at_end()) {
+			// Escape sequence, advance one more character
+			if (cur_byte() == '\\') {
 				next_char();
 			}
 
-			token.text.set_end(str_iter); // End the token before the closing quote
+			next_char();
+			skip_to(scan.string(cur, end));
+		}
+
+		token.text.set_end(cur); // End the token before the closing quote
 
-			if (cur_c == "\"")
-				next_char(); // Consume last "
+		if (cur_byte() == '"')
+			next_char(); // Consume last "
+		else
+			token_unterminated = true;
 
-			token.type = STRING_LIT;
+		token.type = STRING_LIT;
+		decode_string_value();
+	}
+	// Raw string literal
+	else if (cur_byte() == '\'') {
+		// Get opening ' count
+		int q_count = 0;
+		do {
+			++q_count;
+			next_char();
 		}
-		// Raw string literal
-		else if (cur_c == "'") {
-			// Get opening ' count
-			int q_count = 0;
-			do {
-				++q_count;
-				next_char();
-			}
-			while (cur_c == "'");
+		while (cur_byte() == '\'');
 
-			// If it doesn't end in " it's malformed
-			if (cur_c != "\"") {
-				token.text.set_end(str_iter);
-				token.type = UNKNOWN;
-			}
-			else {
-				next_char();
-				init_token(); // Start the token after the opening sequence
+		// If it doesn't end in " it's malformed
+		if (cur_byte() != '"') {
+			token.text.set_end(cur);
+			token.type = UNKNOWN;
+		}
+		else {
+			next_char();
+			init_token(); // Start the token after the opening sequence
+
+			token_unterminated = true;
+			while (!at_end()) {
+				// Skip quickly over runs of ordinary characters
+				const char* run_end = scan.string(cur, end);
+				if (run_end != cur) {
+					token.text.set_end(run_end - 1);
+					skip_to(run_end);
+					continue;
+				}
 
-				while (cur_c != "") {
-					// Check for closing pattern
-					if (cur_c == "\"") {
-						int cq_count = 0;
+				// Check for closing pattern
+				if (cur_byte() == '"') {
+					int cq_count = 0;
+					next_char();
+					while (cur_byte() == '\'' && cq_count < q_count) {
+						++cq_count;
 						next_char();
-						while (cur_c == "'" && cq_count < q_count) {
-							++cq_count;
-							next_char();
-						}
-
-						if (cq_count == q_count)
-							break;
 					}
-					// Otherwise just consume normally
-					else {
-						token.text.set_end(str_iter);
+
+					if (cq_count == q_count) {
+						token_unterminated = false;
+						break;
 					}
-					next_char();
 				}
-
-				++token.text.iter_end; // End the token just before the closing sequence
-				token.type = RAW_STRING_LIT;
+				// Otherwise just consume normally
+				else {
+					token.text.set_end(cur);
+				}
+				next_char();
 			}
+
+			++token.text.iter_end; // End the token just before the closing sequence
+			token.type = RAW_STRING_LIT;
 		}
 	}
 
+	if (token_unterminated && diagnostics != nullptr)
+		diagnostics->error(LEX_ERROR, StringSlice(token_start, cur), "Unterminated string literal.");
+}
 
-	bool lex_comment()
-	{
-		// Returns if it was a doc comment or not, so that non-doc comments
-		// can be skipped;
-		bool is_doc = false;
-		if (cur_c == "#") {
-			next_char();
-
-			// Check if it's a doc-comment
-			if (cur_c == ":") {
-				is_doc = true;
-				next_char();
-			}
 
-			init_token(); // Start token just after the "#" or "#:"
+bool Lexer::lex_comment()
+{
+	// Returns if it was a doc comment or not, so that non-doc comments
+	// can be skipped;
+	bool is_doc = false;
+	if (cur_byte() == '#') {
+		next_char();
+
+		// Check if it's a doc-comment
+		if (cur_byte() == ':') {
+			is_doc = true;
+			next_char();
+		}
 
-			while (!is_nl_char(cur_c) && cur_c != "") {
-				next_char();
-			}
+		init_token(); // Start token just after the "#" or "#:"
 
-			token.text.set_end(str_iter);
-			if (is_doc) {
-				token.type = DOC_STRING;
-			}
+		skip_to(scan.comment(cur, end));
+		while (!is_nl_char(cur_byte()) && !at_end()) {
+			next_char();
+			skip_to(scan.comment(cur, end));
 		}
 
-		return is_doc;
+		token.text.set_end(cur);
+		if (is_doc) {
+			token.type = DOC_STRING;
+		}
 	}
 
+	return is_doc;
+}
 
-	void lex_number_literal()
-	{
-		if (is_digit_char(cur_c)) {
-			int dot_count = 0;
-			do {
-				next_char();
-				if (cur_c == ".") {
-					++dot_count;
-					next_char();
-				}
-			}
-			while (is_digit_char(cur_c));
 
-			if (dot_count == 0) {
-				token.type = INTEGER_LIT;
-			}
-			else if (dot_count == 1) {
-				token.type = FLOAT_LIT;
-			}
-		}
+// Decodes the escape sequences of the current string literal token, if
+// it has any, and interns the result as its value.  Without any, the
+// value stays NO_SYMBOL and the contents are just the token text, which
+// saves hashing the (mostly unique) text of every string literal.
+void Lexer::decode_string_value()
+{
+	const char* begin = token.text.begin();
+	const char* end = token.text.end();
 
-		token.text.set_end(str_iter);
+	if (std::memchr(begin, '\\', end - begin) != nullptr) {
+		string_buffer.clear();
+		decode_string_literal(begin, end, &string_buffer);
+		token.value.string = strings->intern(StringSlice(string_buffer.data(), string_buffer.data() + string_buffer.size()));
 	}
+}
 
 
-};
+static inline bool is_base_digit(unsigned char c, unsigned int base)
+{
+	if (base == 16)
+		return is_digit_char(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+	else if (base == 2)
+		return c == '0' || c == '1';
+	else
+		return is_digit_char(c);
+}
 
 
-void check_for_keyword(Token& token)
+// Consumes digits in the given base, with single underscores between
+// them.
+void Lexer::lex_digits(unsigned int base)
 {
-	// Scoping
-	if (token.text == "namespace") {
-		token.type = K_NAMESPACE;
-	}
-	else if (token.text == "pub") {
-		token.type = K_PUB;
-	}
-	else if (token.text == "unsafe") {
-		token.type = K_UNSAFE;
-	}
+	while (is_base_digit(cur_byte(), base) || (cur_byte() == '_' && is_base_digit(peek_byte(1), base)))
+		next_char();
+}
 
-	// Handle declarations
-	else if (token.text == "const") {
-		token.type = K_CONST;
-	}
-	else if (token.text == "val") {
-		token.type = K_VAL;
-	}
-	else if (token.text == "var") {
-		token.type = K_VAR;
-	}
 
-	// Handle modifiers
-	else if (token.text == "mut") {
-		token.type = K_MUT;
-	}
-	else if (token.text == "ref") {
-		token.type = K_REF;
-	}
+void Lexer::lex_number_literal()
+{
+	const unsigned char prefix = peek_byte(1) | 0x20; // Lower case
+	const unsigned int base = prefix == 'x' ? 16 : prefix == 'b' ? 2 : 10;
 
-	// Functions
-	else if (token.text == "fn") {
-		token.type = K_FN;
+	// Hexadecimal and binary integers
+	if (cur_byte() == '0' && base != 10 && is_base_digit(peek_byte(2), base)) {
+		next_char();
+		next_char();
+		lex_digits(base);
+		token.type = INTEGER_LIT;
 	}
 
-	// Data types
-	else if (token.text == "struct") {
-		token.type = K_STRUCT;
-	}
-	else if (token.text == "enum") {
-		token.type = K_ENUM;
-	}
-	else if (token.text == "union") {
-		token.type = K_UNION;
-	}
+	// Decimal integers and floats
+	else if (is_digit_char(cur_byte())) {
+		int dot_count = 0;
+		do {
+			next_char();
+			if (cur_byte() == '_' && is_digit_char(peek_byte(1))) {
+				next_char();
+			}
+			else if (cur_byte() == '.') {
+				++dot_count;
+				next_char();
+			}
+		}
+		while (is_digit_char(cur_byte()));
+
+		// Exponent
+		bool has_exponent = false;
+		if (dot_count <= 1 && (cur_byte() | 0x20) == 'e') {
+			const unsigned char sign = peek_byte(1);
+			const size_t digits_at = (sign == '+' || sign == '-') ? 2 : 1;
+			if (is_digit_char(peek_byte(digits_at))) {
+				for (size_t i = 0; i < digits_at; ++i)
+					next_char();
+				lex_digits(10);
+				has_exponent = true;
+			}
+		}
 
-	// Traits
-	else if (token.text == "trait") {
-		token.type = K_TRAIT;
-	}
-	else if (token.text == "is") {
-		token.type = K_IS;
+		if (dot_count == 0 && !has_exponent) {
+			token.type = INTEGER_LIT;
+		}
+		else if (dot_count <= 1) {
+			token.type = FLOAT_LIT;
+		}
 	}
 
-	// Control flow
-	else if (token.text == "if") {
-		token.type = K_IF;
-	}
-	else if (token.text == "else") {
-		token.type = K_ELSE;
-	}
-	else if (token.text == "loop") {
-		token.type = K_LOOP;
-	}
-	else if (token.text == "while") {
-		token.type = K_WHILE;
-	}
-	else if (token.text == "until") {
-		token.type = K_UNTIL;
-	}
-	else if (token.text == "for") {
-		token.type = K_FOR;
-	}
-	else if (token.text == "in") {
-		token.type = K_IN;
-	}
-	else if (token.text == "break") {
-		token.type = K_BREAK;
-	}
-	else if (token.text == "continue") {
-		token.type = K_CONTINUE;
+	token.text.set_end(cur);
+
+	// Literals that are out of range are reported, and then kept as zero
+	// so that parsing can carry on.  Without anywhere to report them
+	// they're as good as malformed.
+	if (token.type == INTEGER_LIT) {
+		if (!decode_integer_literal(token.text.begin(), token.text.end(), &token.value.integer)) {
+			if (diagnostics != nullptr) {
+				diagnostics->error(LEX_ERROR, token.text, "Integer literal out of range.");
+				token.value.integer = 0;
+			}
+			else {
+				token.type = UNKNOWN;
+			}
+		}
 	}
-	else if (token.text == "return") {
-		token.type = K_RETURN;
+	else if (token.type == FLOAT_LIT) {
+		if (!decode_float_literal(token.text.begin(), token.text.end(), &token.value.real)) {
+			if (diagnostics != nullptr) {
+				diagnostics->error(LEX_ERROR, token.text, "Float literal out of range.");
+				token.value.real = 0.0;
+			}
+			else {
+				token.type = UNKNOWN;
+			}
+		}
 	}
+}
 
-	// Type casting
-	else if (token.text == "as") {
-		token.type = K_AS;
-	}
 
-	// Misc
-	else if (token.text == "alias") {
-		token.type = K_ALIAS;
-	}
-	else if (token.text == "type") {
-		token.type = K_TYPE;
-	}
+// Hash function for keyword lookup.  It's a perfect hash for the
+// keywords in check_for_keyword(), where the hash values are used as case
+// labels, so a collision is caught by the compiler as a duplicate case.
+static constexpr unsigned int keyword_hash(const char* text, size_t length)
+{
+	return (static_cast<unsigned char>(text[0]) * 5 + static_cast<unsigned char>(text[length - 1]) * 13 + length * 2) & 63;
+}
+
+
+void check_for_keyword(Token& token)
+{
+	const char* text = token.text.begin();
+	const size_t length = token.text.length();
+
+	// Keywords are between two and nine bytes long
+	if (length < 2 || length > 9)
+		return;
+
+#define KEYWORD(str, keyword_type) \
+	case keyword_hash(str, sizeof(str) - 1): \
+		if (length == (sizeof(str) - 1) && std::memcmp(text, str, length) == 0) \
+			token.type = keyword_type; \
+		return;
+
+	switch (keyword_hash(text, length)) {
+		// Scoping
+		KEYWORD("namespace", K_NAMESPACE)
+		KEYWORD("pub", K_PUB)
+		KEYWORD("unsafe", K_UNSAFE)
+
+		// Handle declarations
+		KEYWORD("const", K_CONST)
+		KEYWORD("val", K_VAL)
+		KEYWORD("var", K_VAR)
+
+		// Handle modifiers
+		KEYWORD("mut", K_MUT)
+		KEYWORD("ref", K_REF)
+
+		// Functions
+		KEYWORD("fn", K_FN)
+
+		// Data types
+		KEYWORD("struct", K_STRUCT)
+		KEYWORD("enum", K_ENUM)
+		KEYWORD("union", K_UNION)
+
+		// Traits
+		KEYWORD("trait", K_TRAIT)
+		KEYWORD("is", K_IS)
+
+		// Control flow
+		KEYWORD("if", K_IF)
+		KEYWORD("else", K_ELSE)
+		KEYWORD("loop", K_LOOP)
+		KEYWORD("while", K_WHILE)
+		KEYWORD("until", K_UNTIL)
+		KEYWORD("for", K_FOR)
+		KEYWORD("in", K_IN)
+		KEYWORD("break", K_BREAK)
+		KEYWORD("continue", K_CONTINUE)
+		KEYWORD("return", K_RETURN)
+
+		// Type casting
+		KEYWORD("as", K_AS)
+
+		// Misc
+		KEYWORD("alias", K_ALIAS)
+		KEYWORD("type", K_TYPE)
+
+		default:
+			return;
+	}
+
+#undef KEYWORD
 }
 
 
 std::vector<Token> lex_string(const std::string& input)
 {
 	std::vector<Token> tokens;
-	Lexer lexer = Lexer(input.cbegin(), input.cend());
+	Lexer lexer = Lexer(input.data(), input.data() + input.size());
 
 	// Lex away!
 	while (true) {
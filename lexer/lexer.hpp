@@ -2,16 +2,289 @@
 #define LEXER_HPP
 
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "diagnostics.hpp"
+#include "lexer_scan.hpp"
 #include "lexer_utils.hpp"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
 #include "tokens.hpp"
 
 
+/**
+ * Lexes utf8 input one token at a time.
+ *
+ * The lexer doesn't own the input, which must outlive both it and the
+ * tokens it produces.  Identifiers and operators are interned into a
+ * SymbolTable as they're lexed, global_symbols() unless told otherwise.
+ * Literals are decoded into the token's value.  String literals with
+ * escape sequences have their decoded contents interned into
+ * global_strings() (or as told), and the rest are their own text.
+ */
+class Lexer
+{
+	const char* cur; // Pointer to the first byte of the current character
+	const char* end;
+	unsigned int cur_len = 0; // Length in bytes of the current character, zero at the end of input
+	TokenType last_token_type = UNKNOWN;
+	Token token;
+	const char* token_start = nullptr; // Where lexing of the last token started, including any opening delimiter
+	bool token_unterminated = false; // Whether the last token was a string literal cut off by the end of input
+
+	const ScanKernels& scan = scan_kernels();
+	SymbolTable* symbols = &global_symbols();
+	SymbolTable* strings = &global_strings();
+	std::string string_buffer; // For decoding string literals
+	DiagnosticEngine* diagnostics = nullptr; // Where to report errors, if anywhere
+
+	// The generic stack acts as if it were padded at the bottom with an
+	// unlimited number of false entries.  That's indistinguishable from
+	// an empty stack, but lets a lexer started partway through a file (see
+	// lex_string_parallel()) keep track of how much it relied on the state
+	// it started with.
+	std::vector<bool> generic_stack = {false};
+	size_t underflow_pops = 0; // Padding entries popped
+	size_t underflow_depth = 0; // How far into the padding was looked at
+
+
+public:
+	/**
+	 * Validates the whole input up front, so that lexing itself never has
+	 * to check for malformed utf8.
+	 *
+	 * Throws a utf8_parse_error exception with the offset of the first
+	 * malformed sequence, if any.
+	 */
+	Lexer(const char* begin, const char* end): cur {begin}, end {end}
+	{
+		const char* bad = validate_utf8(begin, end);
+		if (bad != end)
+			throw utf8_parse_error {static_cast<size_t>(bad - begin)};
+
+		cur_len = utf8_char_length(cur, end);
+	}
+
+	/**
+	 * Same as above, except that malformed utf8 is reported to diagnostics
+	 * rather than thrown, along with any errors found while lexing.  Input
+	 * with malformed utf8 lexes as empty, since the lexer can't safely
+	 * read any of it.
+	 */
+	Lexer(const char* begin, const char* end, DiagnosticEngine& diagnostics): cur {begin}, end {end}, diagnostics {&diagnostics}
+	{
+		const char* bad = validate_utf8(begin, end);
+		if (bad != end) {
+			while (bad != end) {
+				diagnostics.error(LEX_ERROR, StringSlice(bad, bad + 1), "Invalid UTF8 sequence.");
+
+				// Resume after the bad byte and any continuation bytes
+				// that belonged with it.
+				const char* resume = bad + 1;
+				while (resume < end && (static_cast<unsigned char>(*resume) & 0xC0) == 0x80)
+					++resume;
+				bad = validate_utf8(resume, end);
+			}
+			cur = end;
+		}
+
+		cur_len = utf8_char_length(cur, end);
+	}
+
+	/**
+	 * Starts lexing partway through a file, in the given state.  A chunk
+	 * lexed with an empty generic_stack can be checked against the real
+	 * state afterwards, with the generic_underflow_*() methods.
+	 *
+	 * This doesn't validate the input, which must have been checked with
+	 * validate_utf8() already.
+	 */
+	Lexer(const char* begin, const char* end, std::vector<bool> generic_stack, TokenType last_token_type, SymbolTable& symbols = global_symbols(), SymbolTable& strings = global_strings()): cur {begin}, end {end}, last_token_type {last_token_type}, symbols {&symbols}, strings {&strings}, generic_stack(std::move(generic_stack))
+	{
+		cur_len = utf8_char_length(cur, end);
+	}
+
+
+	/**
+	 * Lexes and returns a single token.
+	 *
+	 * Always leaves the iterator on the last unconsumed character.
+	 */
+	Token lex_token();
+
+
+	// Current position, just after the last token
+	const char* position() const
+	{
+		return cur;
+	}
+
+	// Where lexing of the last token started.  This can differ from the
+	// start of its text, e.g. string literal text excludes the quotes.
+	const char* last_token_start() const
+	{
+		return token_start;
+	}
+
+	// Whether the last token was a string literal that was still open when
+	// the input ran out
+	bool last_token_unterminated() const
+	{
+		return token_unterminated;
+	}
+
+	const std::vector<bool>& generic_state() const
+	{
+		return generic_stack;
+	}
+
+	size_t generic_underflow_pops() const
+	{
+		return underflow_pops;
+	}
+
+	size_t generic_underflow_depth() const
+	{
+		return underflow_depth;
+	}
+
+
+private:
+	bool at_end() const
+	{
+		return cur_len == 0;
+	}
+
+	// Returns the first byte of the current character, or zero at the end
+	// of input.  Note that zero is also a legal character in the input, so
+	// use at_end() when the distinction matters.
+	unsigned char cur_byte() const
+	{
+		return at_end() ? 0 : *cur;
+	}
+
+	// Returns the byte n bytes past the start of the current character, or
+	// zero if that's past the end of input.
+	unsigned char peek_byte(size_t n) const
+	{
+		return (end - cur) > static_cast<ptrdiff_t>(n) ? cur[n] : 0;
+	}
+
+	// Whether the current character is an identifier character, which
+	// the character class table settles from its first byte alone
+	bool at_ident_char() const
+	{
+		return !at_end() && (char_class(*cur) & CC_IDENT);
+	}
+
+	void next_char()
+	{
+		cur += cur_len;
+		cur_len = utf8_char_length(cur, end);
+	}
+
+	// Jumps ahead to new_cur, which must be the result of one of the scan
+	// kernels: they only stop on ASCII bytes, so new_cur is on a character
+	// boundary.
+	void skip_to(const char* new_cur)
+	{
+		if (new_cur != cur) {
+			cur = new_cur;
+			cur_len = utf8_char_length(cur, end);
+		}
+	}
+
+	void init_token()
+	{
+		token.type = UNKNOWN;
+		token.symbol = NO_SYMBOL;
+		token.value.integer = 0;
+		token.text.set_begin(cur);
+		token.text.set_end(cur);
+	}
+
+
+	// Some utility functions for lexing generic delimeters properly
+	void push_generic(bool state)
+	{
+		generic_stack.push_back(state);
+	}
+
+	void pop_generic(bool state)
+	{
+		if (generic_stack.size() > 0) {
+			if (generic_stack.back() == state)
+				generic_stack.pop_back();
+		}
+		else {
+			note_generic_underflow();
+			if (state == false)
+				++underflow_pops;
+		}
+	}
+
+	bool in_generic()
+	{
+		if (generic_stack.size() > 0)
+			return generic_stack.back();
+
+		note_generic_underflow();
+		return false;
+	}
+
+	void note_generic_underflow()
+	{
+		if (underflow_depth < underflow_pops + 1)
+			underflow_depth = underflow_pops + 1;
+	}
+
+
+	// lexer.cpp
+	void lex_string_literal();
+	bool lex_comment(); // Returns whether it was a doc comment
+	void lex_number_literal();
+	void lex_digits(unsigned int base);
+	void decode_string_value();
+};
+
+
 /**
  * Takes an input string encoded in utf8 and lexes it into a vector of tokens.
  */
 std::vector<Token> lex_string(const std::string& input);
 
 
+/**
+ * Same as lex_string(), but splits the input into chunks of roughly
+ * chunk_size bytes and lexes them on the given thread pool (the default
+ * one if none is given).
+ *
+ * Chunks are split at newlines, but some lexer state still carries
+ * across lines.  So the chunks are stitched back together in order
+ * afterwards, checking each against the true state at its start and
+ * re-lexing sequentially where they don't match.  The result is always
+ * identical to sequential lexing.
+ */
+std::vector<Token> lex_string_parallel(const std::string& input, ThreadPool& pool, size_t chunk_size = 1 << 20);
+std::vector<Token> lex_string_parallel(const std::string& input, size_t chunk_size = 1 << 20);
+
+
+/**
+ * Returns the contents of a string literal token, with any escape
+ * sequences decoded.
+ */
+inline StringSlice string_literal_value(const Token& token)
+{
+	return token.value.string != NO_SYMBOL ? global_strings().text(token.value.string) : token.text;
+}
+
+
+/**
+ * Checks if an identifier token is actually a keyword, and if so changes
+ * its type to the appropriate keyword token type.
+ */
+void check_for_keyword(Token& token);
+
+
 #endif // LEXER_HPP
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+#include "lexer_incremental.hpp"
+#include "lexer_literals.hpp"
+#include "lexer_scan.hpp"
+#include "thread_pool.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+BENCHMARK("lexer: lex_string() throughput")
+{
+	const std::string input = generate_corpus(8 * 1024 * 1024, true);
+
+	size_t token_count = 0;
+	const double t = bench_best_time([&]() {
+		token_count = lex_string(input).size();
+	});
+
+	std::printf("    %lu bytes, %lu tokens\n", (unsigned long)input.size(), (unsigned long)token_count);
+	bench_report_throughput("lex_string()", input.size(), t);
+}
+
+
+BENCHMARK("lexer: lex_string_parallel() throughput")
+{
+	const std::string input = generate_corpus(64 * 1024 * 1024, true);
+
+	std::printf("    %lu bytes, %lu threads\n", (unsigned long)input.size(), (unsigned long)default_thread_pool().size());
+
+	bench_report_throughput("sequential", input.size(), bench_best_time([&]() {
+		Lexer lexer(input.data(), input.data() + input.size());
+		std::vector<Token> tokens;
+		for (Token t = lexer.lex_token(); t.type != LEX_EOF; t = lexer.lex_token())
+			tokens.push_back(t);
+	}));
+
+	const size_t chunk_sizes[] = {256 * 1024, 1 << 20, 4 << 20};
+	for (auto chunk_size: chunk_sizes) {
+		char label[64];
+		std::snprintf(label, sizeof(label), "parallel, %luKB chunks", (unsigned long)(chunk_size / 1024));
+		bench_report_throughput(label, input.size(), bench_best_time([&]() {
+			lex_string_parallel(input, chunk_size);
+		}));
+	}
+}
+
+
+BENCHMARK("lexer: TokenBuffer vs token vector")
+{
+	const std::string input = generate_corpus(8 * 1024 * 1024, true);
+
+	const auto tokens = lex_string(input);
+	const TokenBuffer buffer(input);
+	std::printf("    token vector: %lu bytes (%.1f per token)\n", (unsigned long)(tokens.capacity() * sizeof(Token)), (double)(tokens.capacity() * sizeof(Token)) / tokens.size());
+	std::printf("    TokenBuffer:  %lu bytes (%.1f per token)\n", (unsigned long)buffer.memory_usage(), (double)buffer.memory_usage() / buffer.size());
+
+	bench_report_throughput("TokenBuffer construction", input.size(), bench_best_time([&]() {
+		TokenBuffer b(input);
+	}));
+
+	// Walking the whole stream, skipping newlines the way the parser does
+	bench_report_rate("TokenStream over lexer", tokens.size(), bench_best_time([&]() {
+		TokenStream s(input);
+		while (s->type != LEX_EOF) {
+			++s;
+			s.skip(NEWLINE);
+		}
+	}));
+
+	bench_report_rate("TokenStream over TokenBuffer", tokens.size(), bench_best_time([&]() {
+		TokenStream s(buffer);
+		while (s->type != LEX_EOF) {
+			++s;
+			s.skip(NEWLINE);
+		}
+	}));
+}
+
+
+BENCHMARK("lexer: relex_edit() vs re-lexing the whole file")
+{
+	const std::string input = generate_corpus(8 * 1024 * 1024, true);
+
+	// A keystroke in the middle of the file, typed and then deleted again.
+	// The tokens always point into one of the two versions of the source.
+	size_t offset = input.size() / 2;
+	while (input[offset] != ' ')
+		++offset;
+	SourceEdit type_key;
+	type_key.offset = offset;
+	type_key.inserted = "x";
+	SourceEdit delete_key;
+	delete_key.offset = offset;
+	delete_key.removed = 1;
+	std::string typed = input;
+	typed.insert(offset, "x");
+
+	LexedTokens lexed = lex_with_snapshots(input);
+	std::printf("    %lu bytes, %lu tokens, %lu snapshots\n", (unsigned long)input.size(), (unsigned long)lexed.tokens.size(), (unsigned long)lexed.snapshots.size());
+
+	bench_report_throughput("lex_string()", input.size(), bench_best_time([&]() {
+		lex_string(typed);
+	}));
+
+	bench_report_throughput("lex_with_snapshots()", input.size(), bench_best_time([&]() {
+		lex_with_snapshots(typed);
+	}));
+
+	// Re-lexing is cheap, but the tokens after the edit still all have to
+	// be shifted, so this stays linear in the file size.
+	size_t relexed = 0;
+	const double t = bench_best_time([&]() {
+		relexed = relex_edit(lexed, input, typed, type_key);
+		relex_edit(lexed, typed, input, delete_key);
+	}) / 2;
+	std::printf("    %-40s %10.3f ms  (%lu tokens re-lexed)\n", "relex_edit(), one keystroke", t * 1000.0, (unsigned long)relexed);
+}
+
+
+// Input dominated by long comment blocks and long generated identifiers,
+// where the lexer's inner loops matter most.
+static std::string generate_comment_heavy_input(size_t target_bytes)
+{
+	std::string s;
+	size_t i = 0;
+	while (s.size() < target_bytes) {
+		s += "# ------------------------------------------------------------------------------------\n";
+		s += "# This is a long comment block of the kind that code generators love to emit, which\n";
+		s += "# goes on for quite a while and doesn't say anything especially useful at all.\n";
+		s += "# ------------------------------------------------------------------------------------\n";
+		s += "val generated_identifier_with_a_very_long_name_number_" + std::to_string(i);
+		s += " = another_generated_identifier_with_a_long_name_" + std::to_string(i) + "\n";
+		++i;
+	}
+	return s;
+}
+
+
+BENCHMARK("lexer: lex_string() throughput, comment-heavy input")
+{
+	const std::string input = generate_comment_heavy_input(8 * 1024 * 1024);
+
+	const double t = bench_best_time([&]() {
+		lex_string(input);
+	});
+
+	bench_report_throughput("lex_string()", input.size(), t);
+}
+
+
+BENCHMARK("lexer: scan kernels")
+{
+	const std::string ws(1 << 20, ' ');
+	const std::string ident(1 << 20, 'x');
+	const std::string comment = generate_comment_heavy_input(1 << 20);
+
+	const ScanKernels* kernel_sets[] = {scalar_scan_kernels(), sse2_scan_kernels(), avx2_scan_kernels()};
+
+	for (auto k: kernel_sets) {
+		if (k == nullptr)
+			continue;
+
+		std::printf("  %s\n", k->name);
+
+		bench_report_throughput("whitespace", ws.size(), bench_best_time([&]() {
+			k->whitespace(ws.data(), ws.data() + ws.size());
+		}, 0.2));
+
+		bench_report_throughput("identifier", ident.size(), bench_best_time([&]() {
+			k->identifier(ident.data(), ident.data() + ident.size());
+		}, 0.2));
+
+		// Scan each comment line separately, like the lexer does
+		bench_report_throughput("comment lines", comment.size(), bench_best_time([&]() {
+			const char* p = comment.data();
+			const char* end = comment.data() + comment.size();
+			while (p < end)
+				p = k->comment(p, end) + 1;
+		}, 0.2));
+	}
+}
+
+
+BENCHMARK("lexer: validate_utf8()")
+{
+	const std::string ascii = generate_corpus(8 * 1024 * 1024, true);
+
+	// Mostly ASCII with a sprinkling of multi-byte characters, like
+	// comments written in other languages.
+	std::string mixed = ascii;
+	for (size_t i = 0; i + 3 < mixed.size(); i += 97) {
+		mixed[i] = '\xE6';
+		mixed[i + 1] = '\xBC';
+		mixed[i + 2] = '\xA2';
+	}
+
+	bench_report_throughput("ASCII input", ascii.size(), bench_best_time([&]() {
+		validate_utf8(ascii.data(), ascii.data() + ascii.size());
+	}));
+
+	bench_report_throughput("mixed input", mixed.size(), bench_best_time([&]() {
+		validate_utf8(mixed.data(), mixed.data() + mixed.size());
+	}));
+}
+
+
+BENCHMARK("lexer: float literal decoding")
+{
+	// Short literals like people write, and full-precision ones like
+	// generated code emits.
+	std::mt19937_64 rng(1);
+	std::vector<std::string> short_literals;
+	std::vector<std::string> long_literals;
+	for (int i = 0; i < 100000; ++i) {
+		char buf[40];
+		std::snprintf(buf, sizeof(buf), "%d.%d", static_cast<int>(rng() % 1000), static_cast<int>(rng() % 1000));
+		short_literals.push_back(buf);
+		const double d = static_cast<double>(rng() % 1000000) / (1 + rng() % 1000) * (rng() % 2 ? 1e-30 : 1e30);
+		std::snprintf(buf, sizeof(buf), "%.17e", d);
+		long_literals.push_back(buf);
+	}
+
+	const std::vector<std::string>* sets[] = {&short_literals, &long_literals};
+	const char* names[] = {"short", "full precision"};
+	for (int set = 0; set < 2; ++set) {
+		const auto& literals = *sets[set];
+		double sum = 0.0;
+		char label[64];
+
+		std::snprintf(label, sizeof(label), "strtod(), %s", names[set]);
+		bench_report_rate(label, literals.size(), bench_best_time([&]() {
+			for (const auto& l: literals)
+				sum += std::strtod(l.c_str(), nullptr);
+		}));
+
+		std::snprintf(label, sizeof(label), "decode_float_literal(), %s", names[set]);
+		bench_report_rate(label, literals.size(), bench_best_time([&]() {
+			for (const auto& l: literals) {
+				double d;
+				decode_float_literal(l.data(), l.data() + l.size(), &d);
+				sum += d;
+			}
+		}));
+
+		// Keep the results alive
+		if (sum == 0.0)
+			std::printf("    (all zero)\n");
+	}
+}
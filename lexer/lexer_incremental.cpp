@@ -0,0 +1,145 @@
+#include "lexer_incremental.hpp"
+#include "lexer.hpp"
+#include "lexer_scan.hpp"
+#include "lexer_utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+static void take_snapshot(const Lexer& lexer, const char* base, size_t token_index, std::vector<LexerSnapshot>* snapshots)
+{
+	LexerSnapshot s;
+	s.token_index = token_index;
+	s.offset = lexer.position() - base;
+	s.last_token_type = NEWLINE;
+	s.generic_stack = lexer.generic_state();
+	snapshots->push_back(std::move(s));
+}
+
+
+LexedTokens lex_with_snapshots(const std::string& source, size_t snapshot_interval)
+{
+	const char* base = source.data();
+
+	LexedTokens lexed;
+	lexed.snapshots.push_back(LexerSnapshot());
+	lexed.snapshot_interval = snapshot_interval;
+
+	Lexer lexer(base, base + source.size());
+	for (Token t = lexer.lex_token(); t.type != LEX_EOF; t = lexer.lex_token()) {
+		lexed.tokens.push_back(t);
+
+		if (t.type == NEWLINE && static_cast<size_t>(lexer.position() - base) >= lexed.snapshots.back().offset + snapshot_interval)
+			take_snapshot(lexer, base, lexed.tokens.size(), &lexed.snapshots);
+	}
+
+	return lexed;
+}
+
+
+// Moves a token's text from one copy of the source to another, shifted by
+// the given number of bytes.
+static void move_token(Token* t, const char* old_base, const char* new_base, ptrdiff_t shift)
+{
+	const char* begin = new_base + (t->text.begin() - old_base) + shift;
+	const char* end = new_base + (t->text.end() - old_base) + shift;
+	t->text = StringSlice(begin, end);
+}
+
+
+size_t relex_edit(LexedTokens& lexed, const std::string& old_source, const std::string& new_source, const SourceEdit& edit)
+{
+	assert(edit.offset + edit.removed <= old_source.size());
+	assert(new_source.size() == old_source.size() - edit.removed + edit.inserted.size());
+
+	const char* old_base = old_source.data();
+	const char* new_base = new_source.data();
+	const ptrdiff_t shift = static_cast<ptrdiff_t>(edit.inserted.size()) - static_cast<ptrdiff_t>(edit.removed);
+	const size_t new_edit_end = edit.offset + edit.inserted.size();
+
+	// The last snapshot strictly before the edit.  The newline token just
+	// before a snapshot looked at the byte at the snapshot's offset, so an
+	// edit right there could still change it.
+	size_t first = 0;
+	while ((first + 1) < lexed.snapshots.size() && lexed.snapshots[first + 1].offset < edit.offset)
+		++first;
+	const LexerSnapshot& start = lexed.snapshots[first];
+
+	// Only the edited text can be malformed.  Validate from the snapshot
+	// through the end of the character the edit ends in.
+	size_t validate_end = new_edit_end;
+	while (validate_end < new_source.size() && (static_cast<unsigned char>(new_base[validate_end]) & 0xC0) == 0x80)
+		++validate_end;
+	const char* bad = validate_utf8(new_base + start.offset, new_base + validate_end);
+	if (bad != new_base + validate_end)
+		throw utf8_parse_error {static_cast<size_t>(bad - new_base)};
+
+	// Re-lex until the lexer lands on an old snapshot past the edit in the
+	// same state, or the input runs out.
+	std::vector<Token> new_tokens;
+	std::vector<LexerSnapshot> new_snapshots;
+	size_t last_snapshot_offset = start.offset;
+	size_t resync = lexed.snapshots.size(); // Old snapshot that was resynchronized with, if any
+	size_t next_old = first + 1; // Next old snapshot that could be resynchronized with
+
+	Lexer lexer(new_base + start.offset, new_base + new_source.size(), start.generic_stack, start.last_token_type);
+	for (Token t = lexer.lex_token(); t.type != LEX_EOF; t = lexer.lex_token()) {
+		new_tokens.push_back(t);
+		if (t.type != NEWLINE)
+			continue;
+
+		const size_t offset = lexer.position() - new_base;
+		if (offset >= new_edit_end) {
+			const size_t old_offset = static_cast<size_t>(static_cast<ptrdiff_t>(offset) - shift);
+			while (next_old < lexed.snapshots.size() && lexed.snapshots[next_old].offset < old_offset)
+				++next_old;
+
+			if (next_old < lexed.snapshots.size() && lexed.snapshots[next_old].offset == old_offset && lexed.snapshots[next_old].generic_stack == lexer.generic_state()) {
+				resync = next_old;
+				break;
+			}
+		}
+
+		if (offset >= last_snapshot_offset + lexed.snapshot_interval) {
+			take_snapshot(lexer, new_base, start.token_index + new_tokens.size(), &new_snapshots);
+			last_snapshot_offset = offset;
+		}
+	}
+
+	// Splice the new tokens in place of the old ones they replace
+	const size_t old_token_end = resync < lexed.snapshots.size() ? lexed.snapshots[resync].token_index : lexed.tokens.size();
+	const size_t replaced = old_token_end - start.token_index;
+
+	std::vector<Token>& tokens = lexed.tokens;
+	if (new_tokens.size() > replaced)
+		tokens.insert(tokens.begin() + old_token_end, new_tokens.size() - replaced, Token());
+	else
+		tokens.erase(tokens.begin() + start.token_index + new_tokens.size(), tokens.begin() + old_token_end);
+	const size_t new_token_end = start.token_index + new_tokens.size();
+
+	// Tokens before the edit only move if the source itself did, and
+	// those after it shift by the size of the edit.
+	if (new_base != old_base) {
+		for (size_t i = 0; i < start.token_index; ++i)
+			move_token(&tokens[i], old_base, new_base, 0);
+	}
+	for (size_t i = new_token_end; i < tokens.size(); ++i)
+		move_token(&tokens[i], old_base, new_base, shift);
+	std::copy(new_tokens.begin(), new_tokens.end(), tokens.begin() + start.token_index);
+
+	// Likewise for the snapshots
+	std::vector<LexerSnapshot>& snapshots = lexed.snapshots;
+	const ptrdiff_t token_shift = static_cast<ptrdiff_t>(new_tokens.size()) - static_cast<ptrdiff_t>(replaced);
+	for (size_t i = resync; i < snapshots.size(); ++i) {
+		snapshots[i].offset += shift;
+		snapshots[i].token_index += token_shift;
+	}
+	snapshots.erase(snapshots.begin() + first + 1, snapshots.begin() + resync);
+	snapshots.insert(snapshots.begin() + first + 1, std::make_move_iterator(new_snapshots.begin()), std::make_move_iterator(new_snapshots.end()));
+
+	return new_tokens.size();
+}
@@ -0,0 +1,82 @@
+#ifndef LEXER_INCREMENTAL_HPP
+#define LEXER_INCREMENTAL_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tokens.hpp"
+
+
+/**
+ * An edit to a source file: removed bytes at offset replaced by the
+ * inserted text.
+ */
+struct SourceEdit {
+	size_t offset = 0;
+	size_t removed = 0;
+	std::string inserted;
+};
+
+
+/**
+ * The lexer's state at a point between two tokens, which is all it needs
+ * to carry on lexing from there: the generic stack, and the type of the
+ * last token (for collapsing newlines).
+ *
+ * Snapshots are only taken right after newline tokens.  Nothing but
+ * string literals spans lines, so that's where lexing can most often be
+ * restarted and where an edited token stream most often resynchronizes
+ * with the old one.
+ */
+struct LexerSnapshot {
+	size_t token_index = 0; // Number of tokens before this point
+	size_t offset = 0; // Byte offset in the source
+	TokenType last_token_type = UNKNOWN;
+	std::vector<bool> generic_stack = {false};
+};
+
+
+/**
+ * Tokens (not including LEX_EOF), along with lexer snapshots taken at
+ * least snapshot_interval bytes apart.  The first snapshot is always the
+ * start of the file.
+ *
+ * Fewer snapshots save memory, but mean more re-lexing around each edit.
+ */
+struct LexedTokens {
+	std::vector<Token> tokens;
+	std::vector<LexerSnapshot> snapshots;
+	size_t snapshot_interval = 0;
+};
+
+#define LEXER_SNAPSHOT_INTERVAL 512
+
+
+/**
+ * Same as lex_string(), but also records lexer snapshots so that the
+ * tokens can later be updated with relex_edit().
+ */
+LexedTokens lex_with_snapshots(const std::string& source, size_t snapshot_interval = LEXER_SNAPSHOT_INTERVAL);
+
+
+/**
+ * Updates tokens after an edit, re-lexing as little as possible.
+ *
+ * Lexing restarts at the last snapshot before the edit, and stops as soon
+ * as it reaches a snapshot past the edit where the lexer is in the same
+ * state as it was before.  Everything after that point is identical to
+ * before, just shifted, so the old tokens and snapshots are kept with
+ * their text moved over to new_source.
+ *
+ * old_source must still be the string the tokens were lexed from, and
+ * new_source is old_source with the edit applied.  Only the edited part
+ * of new_source is validated, and a utf8_parse_error is thrown if it's
+ * malformed (leaving lexed untouched).
+ *
+ * Returns the number of tokens that were re-lexed.
+ */
+size_t relex_edit(LexedTokens& lexed, const std::string& old_source, const std::string& new_source, const SourceEdit& edit);
+
+
+#endif // LEXER_INCREMENTAL_HPP
@@ -0,0 +1,184 @@
+#include "catch.hpp"
+
+#include "config.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+#include "lexer.hpp"
+#include "lexer_incremental.hpp"
+#include "test_utils.hpp"
+
+
+// Applies the edit both incrementally and from scratch, and checks that
+// they agree.  The tokens end up pointing into new_source.  Snapshots only
+// have to be valid, not identical to a from-scratch lexing, so each is
+// checked by lexing from it to the end.
+static void check_edit(LexedTokens& lexed, const std::string& old_source, std::string& new_source, const SourceEdit& edit, size_t* relexed = nullptr)
+{
+	new_source = old_source;
+	new_source.replace(edit.offset, edit.removed, edit.inserted);
+
+	const size_t count = relex_edit(lexed, old_source, new_source, edit);
+	if (relexed != nullptr)
+		*relexed = count;
+
+	const auto expected = lex_string(new_source);
+	REQUIRE(same_tokens(lexed.tokens, new_source, expected, new_source));
+
+	for (const auto& s: lexed.snapshots) {
+		Lexer lexer(new_source.data() + s.offset, new_source.data() + new_source.size(), s.generic_stack, s.last_token_type);
+		size_t i = s.token_index;
+		for (Token t = lexer.lex_token(); t.type != LEX_EOF; t = lexer.lex_token(), ++i) {
+			REQUIRE(i < expected.size());
+			REQUIRE(t.type == expected[i].type);
+			REQUIRE(t.text.begin() == expected[i].text.begin());
+		}
+		REQUIRE(i == expected.size());
+	}
+}
+
+
+TEST_CASE("lex_with_snapshots() matches lex_string()", "[lexer_incremental]")
+{
+	const std::string input = generate_corpus(50000, true);
+	const LexedTokens lexed = lex_with_snapshots(input);
+
+	REQUIRE(same_tokens(lexed.tokens, input, lex_string(input), input));
+	REQUIRE(lexed.snapshots.size() > 50);
+	REQUIRE(lexed.snapshots[0].offset == 0);
+	for (size_t i = 1; i < lexed.snapshots.size(); ++i) {
+		REQUIRE(lexed.snapshots[i].offset >= lexed.snapshots[i - 1].offset + LEXER_SNAPSHOT_INTERVAL);
+		REQUIRE(lexed.tokens[lexed.snapshots[i].token_index - 1].type == NEWLINE);
+	}
+}
+
+
+TEST_CASE("Incremental re-lexing only re-lexes near the edit", "[lexer_incremental]")
+{
+	const std::string source = generate_corpus(50000, true);
+	LexedTokens lexed = lex_with_snapshots(source);
+	const size_t token_count = lexed.tokens.size();
+
+	// Rename an identifier in the middle
+	SourceEdit edit;
+	edit.offset = source.find("local_value_", source.size() / 2);
+	edit.removed = 5;
+	edit.inserted = "a_much_longer_name";
+
+	std::string new_source;
+	size_t relexed = 0;
+	check_edit(lexed, source, new_source, edit, &relexed);
+
+	// At most a couple of snapshot intervals' worth
+	REQUIRE(relexed > 0);
+	REQUIRE(relexed < 400);
+	REQUIRE(relexed < token_count / 20);
+}
+
+
+TEST_CASE("Incremental re-lexing of state that spans lines", "[lexer_incremental]")
+{
+	const std::string source = "a\nb\nc\nd\ne\nf\ng\n";
+
+	struct Case {
+		size_t offset;
+		size_t removed;
+		const char* inserted;
+	};
+	const Case cases[] = {
+		{2, 0, "\""}, // Opens a string literal that never closes
+		{4, 0, "\"x"}, // Likewise, in the middle of a line
+		{2, 0, "`<"}, // Opens a generic
+		{2, 1, "("}, // Bracket changes the generic stack
+		{1, 1, ""}, // Joins two lines
+		{1, 0, "\n\n"}, // More newlines to collapse
+		{1, 0, "\\"}, // Escapes a newline
+		{0, 0, "# "}, // Comments out the first line
+		{13, 1, ""}, // Removes the last newline
+		{14, 0, "h"}, // Appends to the end
+		{0, 14, ""}, // Deletes everything
+		{0, 0, "'\"raw\n"}, // Raw string at the very start
+	};
+
+	for (const auto& c: cases) {
+		INFO(c.offset << " " << c.removed << " " << c.inserted);
+		LexedTokens lexed = lex_with_snapshots(source, 1);
+		SourceEdit edit;
+		edit.offset = c.offset;
+		edit.removed = c.removed;
+		edit.inserted = c.inserted;
+		std::string new_source;
+		check_edit(lexed, source, new_source, edit);
+	}
+}
+
+
+// Random edits made one after another, checked against lexing from
+// scratch after each.
+TEST_CASE("Incremental re-lexing: random edits", "[lexer_incremental]")
+{
+	const char* pieces[] = {
+		"\n", "\n", "\n", " ", "\t", "\\", "\"", "'", "''", "\"'", "#", "#:", "`<", "`", "<", ">",
+		"(", ")", "[", "]", "{", "}", "a", "b1", "42", "1.5", "+", ",", "\r\n", "\xC3\xA9", "0x", "e5",
+	};
+	const size_t piece_count = sizeof(pieces) / sizeof(pieces[0]);
+
+	std::srand(11);
+	for (int round = 0; round < 40; ++round) {
+		// The tokens point into one buffer while the next edit is made in
+		// the other.
+		std::string buffers[2];
+		int current = 0;
+		const int length = std::rand() % 80;
+		for (int i = 0; i < length; ++i)
+			buffers[current] += pieces[std::rand() % piece_count];
+
+		LexedTokens lexed = lex_with_snapshots(buffers[current], std::rand() % 8);
+		for (int e = 0; e < 20; ++e) {
+			const std::string& source = buffers[current];
+
+			// Edits stay on character boundaries
+			SourceEdit edit;
+			do {
+				edit.offset = source.empty() ? 0 : std::rand() % (source.size() + 1);
+			}
+			while (edit.offset < source.size() && (static_cast<unsigned char>(source[edit.offset]) & 0xC0) == 0x80);
+			edit.removed = 0;
+			const int remove_pieces = std::rand() % 3;
+			for (int i = 0; i < remove_pieces && edit.offset + edit.removed < source.size(); ++i) {
+				do {
+					++edit.removed;
+				}
+				while (edit.offset + edit.removed < source.size() && (static_cast<unsigned char>(source[edit.offset + edit.removed]) & 0xC0) == 0x80);
+			}
+			const int insert_pieces = std::rand() % 3;
+			for (int i = 0; i < insert_pieces; ++i)
+				edit.inserted += pieces[std::rand() % piece_count];
+
+			INFO(source << " @" << edit.offset << " -" << edit.removed << " +" << edit.inserted);
+			check_edit(lexed, source, buffers[1 - current], edit);
+			current = 1 - current;
+		}
+	}
+}
+
+
+TEST_CASE("Incremental re-lexing rejects malformed UTF8", "[lexer_incremental]")
+{
+	const std::string source = "a\nb\nc\n";
+	LexedTokens lexed = lex_with_snapshots(source, 1);
+	const auto before = lexed.tokens;
+
+	SourceEdit edit;
+	edit.offset = 4;
+	edit.inserted = "\xC3";
+	std::string new_source = source;
+	new_source.insert(4, edit.inserted);
+
+	REQUIRE_THROWS_AS(relex_edit(lexed, source, new_source, edit), const utf8_parse_error&);
+	REQUIRE(same_tokens(lexed.tokens, source, before, source));
+}
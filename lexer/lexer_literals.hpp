@@ -0,0 +1,56 @@
+#ifndef LEXER_LITERALS_HPP
+#define LEXER_LITERALS_HPP
+
+#include <cstdint>
+#include <string>
+
+
+/**
+ * Decoding of literal tokens into their values.
+ *
+ * The lexer does this once for every literal as it's lexed, and stores
+ * the result in the token's value, so that nothing downstream ever has
+ * to re-parse literal text.
+ */
+
+
+/**
+ * Decodes the text of an integer literal: decimal, hexadecimal with a
+ * "0x" prefix, or binary with a "0b" prefix.  Single underscores between
+ * digits are allowed as separators.
+ *
+ * Returns false if the text isn't a valid integer literal or the value
+ * doesn't fit in 64 bits.
+ */
+bool decode_integer_literal(const char* begin, const char* end, uint64_t* value);
+
+
+/**
+ * Decodes the text of a floating point literal: decimal digits with at
+ * most one '.', and an optional exponent ("e", an optional sign, and
+ * decimal digits).  Single underscores between digits are allowed as
+ * separators.
+ *
+ * The result is correctly rounded.  Most literals are handled by either
+ * Clinger's exact fast path or the Eisel-Lemire algorithm, and only the
+ * rare leftovers (more than 19 significant digits, subnormals) go through
+ * strtod().
+ *
+ * Returns false if the text isn't a valid float literal or the value is
+ * too large to represent.
+ */
+bool decode_float_literal(const char* begin, const char* end, double* value);
+
+
+/**
+ * Decodes the escape sequences in the contents of a string literal,
+ * appending the result to out.
+ *
+ * Recognizes \n, \r, \t, \0, \\, \", \', \xHH and \u{H...} (encoded as
+ * utf8).  Anything else after a backslash, including malformed \x and \u
+ * sequences, is kept as-is.
+ */
+void decode_string_literal(const char* begin, const char* end, std::string* out);
+
+
+#endif // LEXER_LITERALS_HPP
@@ -0,0 +1,231 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+#include "lexer_literals.hpp"
+#include "symbol_table.hpp"
+#include "tokens.hpp"
+
+
+static bool decode_integer(const std::string& text, uint64_t* value)
+{
+	return decode_integer_literal(text.data(), text.data() + text.size(), value);
+}
+
+static bool decode_float(const std::string& text, double* value)
+{
+	return decode_float_literal(text.data(), text.data() + text.size(), value);
+}
+
+static std::string decode_string(const std::string& text)
+{
+	std::string out;
+	decode_string_literal(text.data(), text.data() + text.size(), &out);
+	return out;
+}
+
+// What strtod() makes of a float literal, underscores and all
+static double reference_float(const std::string& text)
+{
+	std::string stripped;
+	for (char c: text) {
+		if (c != '_')
+			stripped.push_back(c);
+	}
+	return std::strtod(stripped.c_str(), nullptr);
+}
+
+// Bitwise equality, so that the sign of zero counts
+static bool same_double(double a, double b)
+{
+	return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+TEST_CASE("Integer literal decoding", "[lexer_literals]")
+{
+	uint64_t value = 0;
+
+	REQUIRE(decode_integer("0", &value));
+	REQUIRE(value == 0);
+	REQUIRE(decode_integer("42", &value));
+	REQUIRE(value == 42);
+	REQUIRE(decode_integer("1_000_000", &value));
+	REQUIRE(value == 1000000);
+	REQUIRE(decode_integer("0x1F", &value));
+	REQUIRE(value == 0x1F);
+	REQUIRE(decode_integer("0Xdead_BEEF", &value));
+	REQUIRE(value == 0xdeadbeef);
+	REQUIRE(decode_integer("0b1010", &value));
+	REQUIRE(value == 10);
+	REQUIRE(decode_integer("18446744073709551615", &value));
+	REQUIRE(value == UINT64_MAX);
+	REQUIRE(decode_integer("0xffffffffffffffff", &value));
+	REQUIRE(value == UINT64_MAX);
+
+	// Overflow
+	REQUIRE(!decode_integer("18446744073709551616", &value));
+	REQUIRE(!decode_integer("0x1_0000_0000_0000_0000", &value));
+	REQUIRE(!decode_integer(std::string(65, '1').insert(0, "0b"), &value));
+
+	// Malformed
+	REQUIRE(!decode_integer("", &value));
+	REQUIRE(!decode_integer("0x", &value));
+	REQUIRE(!decode_integer("1__0", &value));
+	REQUIRE(!decode_integer("_1", &value));
+	REQUIRE(!decode_integer("1_", &value));
+	REQUIRE(!decode_integer("0b102", &value));
+	REQUIRE(!decode_integer("12a", &value));
+}
+
+
+TEST_CASE("Float literal decoding edge cases", "[lexer_literals]")
+{
+	const char* cases[] = {
+		"0.0", "1.", "0.001", "3.14159", "1e10", "1.5e-7", "2E+3", "1_000.000_1",
+		"1e-300", "1e308", "1.7976931348623157e308", "2.2250738585072014e-308",
+		"4.9e-324", "2.4703282292062327e-324", "1e-400",
+		"9007199254740993", "9007199254740993.0", "123456789012345678901234567890",
+		"0.1000000000000000055511151231257827021181583404541015625",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124",
+		"1.00000000000000011102230246251565404236316680908203126",
+		"2.0000000000000004440892098500626161694526672363281250",
+		"7.2057594037927933e16", "1e22", "1e23", "8.98846567431158e307",
+		"0.0000000000000000000000000000000000000001",
+	};
+
+	for (auto text: cases) {
+		double value = -1.0;
+		INFO(text);
+		REQUIRE(decode_float(text, &value));
+		REQUIRE(same_double(value, reference_float(text)));
+	}
+
+	double value = 0.0;
+	REQUIRE(!decode_float("1e309", &value));
+	REQUIRE(!decode_float("1.8e308", &value));
+	REQUIRE(!decode_float("", &value));
+	REQUIRE(!decode_float("1..0", &value));
+	REQUIRE(!decode_float("1e", &value));
+	REQUIRE(!decode_float("1e+", &value));
+	REQUIRE(!decode_float("1__0.0", &value));
+}
+
+
+TEST_CASE("Float literal decoding matches strtod()", "[lexer_literals]")
+{
+	std::mt19937_64 rng(12345);
+	std::vector<std::string> texts;
+
+	// Random digit strings with random exponents, over the whole range
+	for (int i = 0; i < 20000; ++i) {
+		std::string text;
+		const int int_digits = 1 + rng() % 20;
+		const int frac_digits = rng() % 20;
+		for (int d = 0; d < int_digits; ++d)
+			text.push_back('0' + rng() % 10);
+		text.push_back('.');
+		for (int d = 0; d < frac_digits; ++d)
+			text.push_back('0' + rng() % 10);
+		text += "e" + std::to_string(static_cast<int>(rng() % 660) - 340);
+		texts.push_back(text);
+	}
+
+	// Round trips of random doubles at full precision
+	for (int i = 0; i < 20000; ++i) {
+		const uint64_t bits = rng() & 0x7FEFFFFFFFFFFFFFull;
+		double d;
+		std::memcpy(&d, &bits, sizeof(d));
+		char buf[40];
+		std::snprintf(buf, sizeof(buf), "%.17e", d);
+		texts.push_back(buf);
+		std::snprintf(buf, sizeof(buf), "%.16e", d);
+		texts.push_back(buf);
+	}
+
+	for (const auto& text: texts) {
+		double value = 0.0;
+		const double reference = reference_float(text);
+		if (std::isinf(reference)) {
+			REQUIRE(!decode_float(text, &value));
+		}
+		else {
+			INFO(text);
+			REQUIRE(decode_float(text, &value));
+			REQUIRE(same_double(value, reference));
+		}
+	}
+}
+
+
+TEST_CASE("String literal decoding", "[lexer_literals]")
+{
+	REQUIRE(decode_string("plain") == "plain");
+	REQUIRE(decode_string("a\\nb\\tc\\r") == "a\nb\tc\r");
+	REQUIRE(decode_string("\\\\ \\\" \\'") == "\\ \" '");
+	REQUIRE(decode_string("\\0") == std::string(1, '\0'));
+	REQUIRE(decode_string("\\x41\\x7e") == "A~");
+	REQUIRE(decode_string("\\u{41}\\u{e9}\\u{20AC}\\u{1F600}") == "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+
+	// Unknown and malformed escapes are kept verbatim
+	REQUIRE(decode_string("\\q") == "\\q");
+	REQUIRE(decode_string("\\x4") == "\\x4");
+	REQUIRE(decode_string("\\u{}") == "\\u{}");
+	REQUIRE(decode_string("\\u{110000}") == "\\u{110000}");
+	REQUIRE(decode_string("\\u{41") == "\\u{41");
+	REQUIRE(decode_string("trailing\\") == "trailing\\");
+}
+
+
+TEST_CASE("Lexer number literal forms", "[lexer]")
+{
+	const std::string input = "0x1F 1_000 1.5e10 2e 0b101 1e400 99999999999999999999 1.2.3 0xg";
+	const auto tokens = lex_string(input);
+
+	const std::vector<TokenType> types {
+		INTEGER_LIT, INTEGER_LIT, FLOAT_LIT, INTEGER_LIT, IDENTIFIER, INTEGER_LIT,
+		UNKNOWN, UNKNOWN, UNKNOWN, INTEGER_LIT, IDENTIFIER
+	};
+
+	REQUIRE(tokens.size() == types.size());
+	for (size_t i = 0; i < types.size(); ++i) {
+		INFO(i);
+		REQUIRE(tokens[i].type == types[i]);
+	}
+
+	REQUIRE(tokens[0].value.integer == 0x1F);
+	REQUIRE(tokens[1].value.integer == 1000);
+	REQUIRE(tokens[2].value.real == 1.5e10);
+	REQUIRE(tokens[3].text == "2");
+	REQUIRE(tokens[4].text == "e");
+	REQUIRE(tokens[5].value.integer == 5);
+	REQUIRE(tokens[9].text == "0");
+	REQUIRE(tokens[10].text == "xg");
+}
+
+
+TEST_CASE("Lexer string literal values", "[lexer]")
+{
+	const std::string input = "\"a\\tb\" \"plain\" '\"raw\\t\"' \"plain\"";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 4);
+	REQUIRE(tokens[0].type == STRING_LIT);
+	REQUIRE(string_literal_value(tokens[0]) == "a\tb");
+	REQUIRE(string_literal_value(tokens[1]) == "plain");
+	REQUIRE(tokens[2].type == RAW_STRING_LIT);
+	REQUIRE(string_literal_value(tokens[2]) == "raw\\t");
+
+	// Only escaped strings need a decoded copy
+	REQUIRE(tokens[0].value.string != NO_SYMBOL);
+	REQUIRE(tokens[1].value.string == NO_SYMBOL);
+	REQUIRE(tokens[2].value.string == NO_SYMBOL);
+}
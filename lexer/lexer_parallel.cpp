@@ -0,0 +1,237 @@
+#include "lexer.hpp"
+#include "lexer_scan.hpp"
+#include "lexer_utils.hpp"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
+#include "tokens.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+// The results of lexing one chunk, along with what's needed to check it
+// against the real lexer state at its start.
+struct LexedChunk {
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	std::vector<Token> tokens; // Not including LEX_EOF
+	SymbolTable symbols; // Chunk-local symbol IDs, mapped to global ones when stitching
+	SymbolTable strings; // Likewise for string literals
+	bool last_unterminated = false; // The last token is a string literal that runs past the end of the chunk
+	const char* last_start = nullptr; // Where lexing of the last token started
+
+	std::vector<bool> generic_stack; // What's left on the generic stack at the end of the chunk
+	size_t generic_pops = 0;
+	size_t generic_depth = 0;
+
+	bool utf8_error = false;
+	size_t utf8_error_offset = 0;
+};
+
+
+// Chunks may only start at a newline that isn't preceded by whitespace or
+// another newline.  Every token then either ends before the split or is a
+// string literal running across it, since nothing else spans lines.  And
+// the newline is the start of a token rather than partway through a run
+// of newlines and whitespace.
+static bool is_split_point(const char* begin, const char* p)
+{
+	return p > begin && *p == '\n' && !is_ws_char(p[-1]) && !is_nl_char(p[-1]);
+}
+
+
+static std::vector<const char*> find_split_points(const char* begin, const char* end, size_t chunk_size)
+{
+	std::vector<const char*> splits;
+	splits.push_back(begin);
+
+	const char* p = begin + chunk_size;
+	while (p < end) {
+		p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		if (p == nullptr)
+			break;
+
+		if (is_split_point(begin, p)) {
+			splits.push_back(p);
+			p += chunk_size;
+		}
+		else {
+			++p;
+		}
+	}
+
+	splits.push_back(end);
+	return splits;
+}
+
+
+static void lex_chunk(LexedChunk* chunk)
+{
+	const char* bad = validate_utf8(chunk->begin, chunk->end);
+	if (bad != chunk->end) {
+		chunk->utf8_error = true;
+		chunk->utf8_error_offset = bad - chunk->begin;
+		return;
+	}
+
+	// Start with an empty generic stack, so that it's possible to check
+	// afterwards how much the chunk depended on the real one.  The first
+	// chunk is no exception: an empty stack behaves the same as the
+	// initial {false}.
+	Lexer lexer(chunk->begin, chunk->end, {}, UNKNOWN, chunk->symbols, chunk->strings);
+
+	while (true) {
+		const Token t = lexer.lex_token();
+		if (t.type == LEX_EOF)
+			break;
+		chunk->tokens.push_back(t);
+		chunk->last_unterminated = lexer.last_token_unterminated();
+		chunk->last_start = lexer.last_token_start();
+	}
+
+	chunk->generic_stack = lexer.generic_state();
+	chunk->generic_pops = lexer.generic_underflow_pops();
+	chunk->generic_depth = lexer.generic_underflow_depth();
+}
+
+
+// Maps each of a chunk's local IDs to its global one.
+static std::vector<uint32_t> global_ids(const SymbolTable& local, SymbolTable& global)
+{
+	std::vector<uint32_t> ids(local.size(), NO_SYMBOL);
+	for (uint32_t id = 1; id < ids.size(); ++id)
+		ids[id] = global.intern(local.text(id));
+	return ids;
+}
+
+
+// Whether a chunk lexed with an empty generic stack behaves the same when
+// started with the given real stack.  It assumed that everything it looked
+// at below its own entries was false.
+static bool generic_state_matches(const LexedChunk& chunk, const std::vector<bool>& stack)
+{
+	for (size_t i = 0; i < chunk.generic_depth && i < stack.size(); ++i) {
+		if (stack[stack.size() - 1 - i])
+			return false;
+	}
+	return true;
+}
+
+
+std::vector<Token> lex_string_parallel(const std::string& input, ThreadPool& pool, size_t chunk_size)
+{
+	const char* begin = input.data();
+	const char* end = input.data() + input.size();
+
+	if (chunk_size == 0)
+		chunk_size = 1;
+
+	// Split up and lex the chunks
+	const std::vector<const char*> splits = find_split_points(begin, end, chunk_size);
+	std::vector<LexedChunk> chunks(splits.size() - 1);
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		chunks[i].begin = splits[i];
+		chunks[i].end = splits[i + 1];
+	}
+
+	pool.run(chunks.size(), [&](size_t i) {
+		lex_chunk(&chunks[i]);
+	});
+
+	// Splits are always on character boundaries, so the first bad chunk has
+	// the first bad sequence.
+	for (const auto& chunk: chunks) {
+		if (chunk.utf8_error)
+			throw utf8_parse_error {static_cast<size_t>(chunk.begin - begin) + chunk.utf8_error_offset};
+	}
+
+	// Stitch the chunks together, tracking the real lexer state as we go
+	size_t token_count = 0;
+	for (const auto& chunk: chunks)
+		token_count += chunk.tokens.size();
+
+	std::vector<Token> tokens;
+	tokens.reserve(token_count);
+
+	std::vector<bool> generic_stack = {false};
+	TokenType last_token_type = UNKNOWN;
+	const char* resume_at = nullptr; // Where to re-lex from if a chunk can't be used
+
+	size_t i = 0;
+	while (i < chunks.size()) {
+		const LexedChunk& chunk = chunks[i];
+
+		if (resume_at == nullptr && !generic_state_matches(chunk, generic_stack))
+			resume_at = chunk.begin;
+
+		// Use the chunk as-is
+		if (resume_at == nullptr) {
+			auto itr = chunk.tokens.begin();
+			auto itr_end = chunk.tokens.end();
+
+			// A chunk starts with a newline, which would have been collapsed
+			// into the previous newline token.
+			if (itr != itr_end && itr->type == NEWLINE && last_token_type == NEWLINE)
+				++itr;
+
+			// A string literal that runs past the end of the chunk has to be
+			// re-lexed, along with everything after it in the next chunk.
+			const bool cut_off = chunk.last_unterminated && (i + 1) < chunks.size();
+			if (cut_off) {
+				--itr_end;
+				resume_at = chunk.last_start;
+			}
+
+			const std::vector<uint32_t> symbol_ids = global_ids(chunk.symbols, global_symbols());
+			const std::vector<uint32_t> string_ids = global_ids(chunk.strings, global_strings());
+			for (; itr != itr_end; ++itr) {
+				tokens.push_back(*itr);
+				tokens.back().symbol = symbol_ids[itr->symbol];
+				if (itr->type == STRING_LIT)
+					tokens.back().value.string = string_ids[itr->value.string];
+			}
+			if (!tokens.empty())
+				last_token_type = tokens.back().type;
+
+			generic_stack.resize(generic_stack.size() - std::min(chunk.generic_pops, generic_stack.size()));
+			generic_stack.insert(generic_stack.end(), chunk.generic_stack.begin(), chunk.generic_stack.end());
+
+			++i;
+			if (!cut_off)
+				continue;
+		}
+
+		// Lex sequentially from resume_at until a token ends exactly at the
+		// start of a later chunk, at which point that chunk can be used.
+		Lexer lexer(resume_at, end, generic_stack, last_token_type);
+		resume_at = nullptr;
+		while (true) {
+			const Token t = lexer.lex_token();
+			if (t.type == LEX_EOF) {
+				i = chunks.size();
+				break;
+			}
+
+			tokens.push_back(t);
+			last_token_type = t.type;
+
+			while (i < chunks.size() && chunks[i].begin < lexer.position())
+				++i;
+			if (i < chunks.size() && chunks[i].begin == lexer.position()) {
+				generic_stack = lexer.generic_state();
+				break;
+			}
+		}
+	}
+
+	return tokens;
+}
+
+
+std::vector<Token> lex_string_parallel(const std::string& input, size_t chunk_size)
+{
+	return lex_string_parallel(input, default_thread_pool(), chunk_size);
+}
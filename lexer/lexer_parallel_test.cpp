@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include "config.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+#include "lexer.hpp"
+#include "test_utils.hpp"
+#include "thread_pool.hpp"
+
+
+// Chunk sizes are in bytes, so the smallest puts a boundary at every line
+static void check_parallel_matches(const std::string& input)
+{
+	const auto expected = lex_string(input);
+	check_chunk_sizes([&](ThreadPool& pool, size_t chunk_size) {
+		REQUIRE(same_tokens(lex_string_parallel(input, pool, chunk_size), expected));
+	});
+}
+
+
+TEST_CASE("Parallel lexing matches sequential: examples", "[lexer]")
+{
+	const char* examples[] = {"dyn_array.rune", "test.rune"};
+	for (auto name: examples) {
+		INFO(name);
+		const std::string input = read_file(std::string(SOURCE_DIR) + "/doc/examples/" + name);
+		REQUIRE(input.size() > 0);
+		check_parallel_matches(input);
+	}
+}
+
+
+TEST_CASE("Parallel lexing matches sequential: generated corpus", "[lexer]")
+{
+	check_parallel_matches(generate_corpus(50000, true));
+}
+
+
+// Constructs whose state carries across lines, right at the places where
+// chunks get split.
+TEST_CASE("Parallel lexing matches sequential: cross-line state", "[lexer]")
+{
+	const char* inputs[] = {
+		// Multi-line string literals
+		"val a = \"one\ntwo\nthree\"\nval b = 2\n",
+		"val a = \"escaped \\\"\nquote\"\nb\n",
+		"val a = '\"raw\nstring\"'\nb\n",
+		"val a = '''\"raw \"'' string\n\"'\nwith\"''' b\nc\n",
+		"val a = \"unterminated\nstring\n",
+		"val a = ''\"unterminated\nraw string\"'\n",
+
+		// Newline collapsing across comments, and escaped newlines
+		"a\n# comment\n# another\nb\n",
+		"a\n#: doc\n\nb\n",
+		"a\n#c\n\\\nb\n",
+		"a \\\n b\nc\n  \\\nd\n",
+		"a\r\nb\r\n\r\nc\n",
+
+		// Generic brackets spanning lines
+		"`<\na >\n>\n",
+		"f(`<a,\nb>\n) > c\n",
+		"`<a `<\nb\n>\n>\n> d\n",
+		"(\n`<\n)\n>\n]\n>\n",
+		"x)\n)\n>\n",
+	};
+
+	for (auto input: inputs) {
+		INFO(input);
+		check_parallel_matches(input);
+	}
+}
+
+
+// Random sequences of pieces that are interesting to the lexer
+TEST_CASE("Parallel lexing matches sequential: random input", "[lexer]")
+{
+	const char* pieces[] = {
+		"\n", "\n", "\n", " ", "\t", "\\", "\"", "'", "''", "\"'", "#", "#:", "`<", "`", "<", ">",
+		"(", ")", "[", "]", "{", "}", "a", "b1", "42", "1.5", "+", ",", "\r\n", "\xC3\xA9",
+	};
+
+	std::srand(7);
+	for (int round = 0; round < 300; ++round) {
+		std::string input;
+		const int length = std::rand() % 60;
+		for (int i = 0; i < length; ++i)
+			input += pieces[std::rand() % (sizeof(pieces) / sizeof(pieces[0]))];
+
+		INFO(input);
+		check_parallel_matches(input);
+	}
+}
+
+
+TEST_CASE("Parallel lexing reports the first malformed UTF8", "[lexer]")
+{
+	const std::string input = std::string("a\nb\nc\xE6\xBC\nd\n\x80\n");
+
+	size_t offset = 0;
+	try {
+		lex_string_parallel(input, 1);
+	}
+	catch (const utf8_parse_error& e) {
+		offset = e.offset;
+	}
+	REQUIRE(offset == 5);
+}
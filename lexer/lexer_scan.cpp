@@ -0,0 +1,323 @@
+#include "lexer_scan.hpp"
+#include "lexer_utils.hpp"
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RUNE_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernels are compiled with per-function target attributes and
+// selected at runtime, which needs GCC/Clang extensions.
+#if defined(RUNE_SCAN_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RUNE_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Returns the index of the lowest set bit.  mask must be non-zero.
+static inline unsigned int lowest_set_bit(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward(&i, mask);
+	return i;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////
+// Scalar kernels
+////////////////////////////////////////////////////////////////
+
+static inline bool scalar_is_ws(unsigned char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool scalar_is_ident(unsigned char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool scalar_is_comment(unsigned char c)
+{
+	return c != '\n' && c != '\r';
+}
+
+static inline bool scalar_is_string(unsigned char c)
+{
+	return c != '"' && c != '\\' && c != '\n' && c != '\r';
+}
+
+static inline bool scalar_is_ascii(unsigned char c)
+{
+	return c < 0x80;
+}
+
+#define SCALAR_SCAN_LOOP(pred) \
+	while (begin < end && pred(static_cast<unsigned char>(*begin))) \
+		++begin; \
+	return begin;
+
+static const char* scalar_whitespace(const char* begin, const char* end)
+{
+	SCALAR_SCAN_LOOP(scalar_is_ws)
+}
+
+static const char* scalar_identifier(const char* begin, const char* end)
+{
+	SCALAR_SCAN_LOOP(scalar_is_ident)
+}
+
+static const char* scalar_comment(const char* begin, const char* end)
+{
+	SCALAR_SCAN_LOOP(scalar_is_comment)
+}
+
+static const char* scalar_string(const char* begin, const char* end)
+{
+	SCALAR_SCAN_LOOP(scalar_is_string)
+}
+
+static const char* scalar_ascii(const char* begin, const char* end)
+{
+	SCALAR_SCAN_LOOP(scalar_is_ascii)
+}
+
+static const ScanKernels scalar_kernels = {
+	"scalar",
+	scalar_whitespace,
+	scalar_identifier,
+	scalar_comment,
+	scalar_string,
+	scalar_ascii,
+};
+
+
+////////////////////////////////////////////////////////////////
+// SSE2 kernels, 16 bytes at a time
+//
+// Each kernel computes a bit mask of the bytes it has to stop at, and
+// finishes with the scalar kernel once fewer than 16 bytes are left.
+////////////////////////////////////////////////////////////////
+#ifdef RUNE_SCAN_SSE2
+
+// Bytes in [lo, hi].  Non-ASCII bytes are negative as signed chars, so
+// they never match ranges within ASCII.
+static inline __m128i sse2_in_range(__m128i v, char lo, char hi)
+{
+	return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+static inline __m128i sse2_eq(__m128i v, char c)
+{
+	return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+#define SSE2_SCAN_LOOP(stop_mask_expr, scalar_func) \
+	while ((end - begin) >= 16) { \
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)); \
+		const uint32_t stop = (stop_mask_expr); \
+		if (stop != 0) \
+			return begin + lowest_set_bit(stop); \
+		begin += 16; \
+	} \
+	return scalar_func(begin, end);
+
+static const char* sse2_whitespace(const char* begin, const char* end)
+{
+	SSE2_SCAN_LOOP(~_mm_movemask_epi8(_mm_or_si128(sse2_eq(v, ' '), sse2_eq(v, '\t'))) & 0xFFFF,
+	               scalar_whitespace)
+}
+
+static const char* sse2_identifier(const char* begin, const char* end)
+{
+	SSE2_SCAN_LOOP(~_mm_movemask_epi8(_mm_or_si128(
+	                   _mm_or_si128(sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'),
+	                                sse2_in_range(v, '0', '9')),
+	                   sse2_eq(v, '_'))) & 0xFFFF,
+	               scalar_identifier)
+}
+
+static const char* sse2_comment(const char* begin, const char* end)
+{
+	SSE2_SCAN_LOOP(_mm_movemask_epi8(_mm_or_si128(sse2_eq(v, '\n'), sse2_eq(v, '\r'))),
+	               scalar_comment)
+}
+
+static const char* sse2_string(const char* begin, const char* end)
+{
+	SSE2_SCAN_LOOP(_mm_movemask_epi8(_mm_or_si128(
+	                   _mm_or_si128(sse2_eq(v, '"'), sse2_eq(v, '\\')),
+	                   _mm_or_si128(sse2_eq(v, '\n'), sse2_eq(v, '\r')))),
+	               scalar_string)
+}
+
+static const char* sse2_ascii(const char* begin, const char* end)
+{
+	SSE2_SCAN_LOOP(_mm_movemask_epi8(v), scalar_ascii)
+}
+
+static const ScanKernels sse2_kernels = {
+	"sse2",
+	sse2_whitespace,
+	sse2_identifier,
+	sse2_comment,
+	sse2_string,
+	sse2_ascii,
+};
+
+#endif // RUNE_SCAN_SSE2
+
+
+////////////////////////////////////////////////////////////////
+// AVX2 kernels, 32 bytes at a time
+//
+// Same as the SSE2 kernels, but twice as wide.  They finish with the
+// SSE2 kernels, which in turn finish with the scalar ones.
+////////////////////////////////////////////////////////////////
+#ifdef RUNE_SCAN_AVX2
+
+#define RUNE_AVX2 __attribute__((target("avx2")))
+
+RUNE_AVX2 static inline __m256i avx2_in_range(__m256i v, char lo, char hi)
+{
+	return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+RUNE_AVX2 static inline __m256i avx2_eq(__m256i v, char c)
+{
+	return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+#define AVX2_SCAN_LOOP(stop_mask_expr, sse2_func) \
+	while ((end - begin) >= 32) { \
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)); \
+		const uint32_t stop = (stop_mask_expr); \
+		if (stop != 0) \
+			return begin + lowest_set_bit(stop); \
+		begin += 32; \
+	} \
+	return sse2_func(begin, end);
+
+RUNE_AVX2 static const char* avx2_whitespace(const char* begin, const char* end)
+{
+	AVX2_SCAN_LOOP(~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(avx2_eq(v, ' '), avx2_eq(v, '\t')))),
+	               sse2_whitespace)
+}
+
+RUNE_AVX2 static const char* avx2_identifier(const char* begin, const char* end)
+{
+	AVX2_SCAN_LOOP(~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(
+	                   _mm256_or_si256(avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'),
+	                                   avx2_in_range(v, '0', '9')),
+	                   avx2_eq(v, '_')))),
+	               sse2_identifier)
+}
+
+RUNE_AVX2 static const char* avx2_comment(const char* begin, const char* end)
+{
+	AVX2_SCAN_LOOP(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(avx2_eq(v, '\n'), avx2_eq(v, '\r')))),
+	               sse2_comment)
+}
+
+RUNE_AVX2 static const char* avx2_string(const char* begin, const char* end)
+{
+	AVX2_SCAN_LOOP(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(
+	                   _mm256_or_si256(avx2_eq(v, '"'), avx2_eq(v, '\\')),
+	                   _mm256_or_si256(avx2_eq(v, '\n'), avx2_eq(v, '\r'))))),
+	               sse2_string)
+}
+
+RUNE_AVX2 static const char* avx2_ascii(const char* begin, const char* end)
+{
+	AVX2_SCAN_LOOP(static_cast<uint32_t>(_mm256_movemask_epi8(v)), sse2_ascii)
+}
+
+static const ScanKernels avx2_kernels = {
+	"avx2",
+	avx2_whitespace,
+	avx2_identifier,
+	avx2_comment,
+	avx2_string,
+	avx2_ascii,
+};
+
+#endif // RUNE_SCAN_AVX2
+
+
+////////////////////////////////////////////////////////////////
+// Dispatch
+////////////////////////////////////////////////////////////////
+
+const ScanKernels* scalar_scan_kernels()
+{
+	return &scalar_kernels;
+}
+
+
+const ScanKernels* sse2_scan_kernels()
+{
+#ifdef RUNE_SCAN_SSE2
+	return &sse2_kernels;
+#else
+	return nullptr;
+#endif
+}
+
+
+const ScanKernels* avx2_scan_kernels()
+{
+#ifdef RUNE_SCAN_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return &avx2_kernels;
+#endif
+	return nullptr;
+}
+
+
+static const ScanKernels* select_scan_kernels()
+{
+	const ScanKernels* k = avx2_scan_kernels();
+	if (k == nullptr)
+		k = sse2_scan_kernels();
+	if (k == nullptr)
+		k = scalar_scan_kernels();
+	return k;
+}
+
+
+const ScanKernels& scan_kernels()
+{
+	static const ScanKernels* kernels = select_scan_kernels();
+	return *kernels;
+}
+
+
+////////////////////////////////////////////////////////////////
+// UTF8 validation
+////////////////////////////////////////////////////////////////
+
+const char* validate_utf8(const char* begin, const char* end)
+{
+	const ScanKernels& k = scan_kernels();
+
+	while (true) {
+		begin = k.ascii(begin, end);
+		if (begin == end)
+			return end;
+
+		const unsigned int len = utf8_sequence_length(begin, end);
+		if (len == 0)
+			return begin;
+		begin += len;
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef LEXER_SCAN_HPP
+#define LEXER_SCAN_HPP
+
+/**
+ * Kernels for quickly skipping over runs of "uninteresting" bytes in the
+ * lexer's inner loops.
+ *
+ * Each kernel takes a [begin, end) byte range and returns a pointer to
+ * the first byte that it can't skip (or end).  They only ever stop on
+ * ASCII bytes, so on validated utf8 input the lexer can jump straight to
+ * the returned position without decoding anything in between.  They're
+ * allowed to stop early, e.g. on bytes that the lexer would in fact
+ * accept but that are rare enough not to bother with.
+ */
+struct ScanKernels {
+	const char* name;
+
+	// Skips ' ' and '\t'
+	const char* (*whitespace)(const char* begin, const char* end);
+
+	// Skips [A-Za-z0-9_], the common identifier bytes
+	const char* (*identifier)(const char* begin, const char* end);
+
+	// Skips everything except newlines
+	const char* (*comment)(const char* begin, const char* end);
+
+	// Skips everything except '"', '\\' and newlines
+	const char* (*string)(const char* begin, const char* end);
+
+	// Skips ASCII bytes.  Unlike the others, this stops on the first
+	// non-ASCII byte, and is used for utf8 validation.
+	const char* (*ascii)(const char* begin, const char* end);
+};
+
+
+/**
+ * Returns the fastest set of kernels supported by the running CPU.
+ * The choice is made once, on first call.
+ */
+const ScanKernels& scan_kernels();
+
+
+/**
+ * Returns specific kernel implementations, mainly for testing and
+ * benchmarking.  The SIMD versions return nullptr if they aren't
+ * compiled in or aren't supported by the running CPU.
+ */
+const ScanKernels* scalar_scan_kernels();
+const ScanKernels* sse2_scan_kernels();
+const ScanKernels* avx2_scan_kernels();
+
+
+/**
+ * Checks that [begin, end) is well-formed utf8, skipping over ASCII a
+ * vector at a time.  Returns a pointer to the first byte of the first
+ * malformed sequence, or end if there isn't one.
+ */
+const char* validate_utf8(const char* begin, const char* end);
+
+
+#endif // LEXER_SCAN_HPP
@@ -0,0 +1,116 @@
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include "lexer_scan.hpp"
+#include "lexer_utils.hpp"
+
+
+// Builds a buffer of random bytes, biased towards the bytes the kernels
+// care about.
+static std::string random_buffer(size_t length, unsigned int seed)
+{
+	const char interesting[] = " \t\n\r\"\\_azAZ09#`@[{\x7F\x80\xC3\xFF";
+	std::srand(seed);
+
+	std::string s;
+	for (size_t i = 0; i < length; ++i) {
+		if (std::rand() % 4 == 0)
+			s.push_back(static_cast<char>(std::rand() % 256));
+		else
+			s.push_back(interesting[std::rand() % (sizeof(interesting) - 1)]);
+	}
+	return s;
+}
+
+
+// Every kernel set must stop at exactly the same place as the scalar
+// kernels, for every starting offset.
+TEST_CASE("SIMD scan kernels match scalar kernels", "[lexer]")
+{
+	const ScanKernels* scalar = scalar_scan_kernels();
+	const ScanKernels* kernel_sets[] = {sse2_scan_kernels(), avx2_scan_kernels(), &scan_kernels()};
+
+	for (auto k: kernel_sets) {
+		if (k == nullptr)
+			continue;
+
+		for (unsigned int seed = 0; seed < 16; ++seed) {
+			// Long runs of the same byte, so that the kernels actually get to
+			// skip full vectors before stopping.
+			std::string s = random_buffer(200, seed);
+			s.insert(50, std::string(70, seed % 2 ? ' ' : 'q'));
+			s.insert(10, std::string(40, seed % 2 ? 'Z' : '_'));
+
+			const char* end = s.data() + s.size();
+			for (size_t i = 0; i <= s.size(); ++i) {
+				const char* begin = s.data() + i;
+				REQUIRE(k->whitespace(begin, end) == scalar->whitespace(begin, end));
+				REQUIRE(k->identifier(begin, end) == scalar->identifier(begin, end));
+				REQUIRE(k->comment(begin, end) == scalar->comment(begin, end));
+				REQUIRE(k->string(begin, end) == scalar->string(begin, end));
+				REQUIRE(k->ascii(begin, end) == scalar->ascii(begin, end));
+			}
+		}
+	}
+}
+
+
+TEST_CASE("Scan kernels stop at the right bytes", "[lexer]")
+{
+	const ScanKernels& k = scan_kernels();
+
+	const std::string ws = std::string(37, ' ') + "\t\t" + "x";
+	REQUIRE(k.whitespace(ws.data(), ws.data() + ws.size()) == ws.data() + 39);
+
+	const std::string ident = "abc_XYZ_0123456789_abcdefghijklmnopqrstuvwxyz+";
+	REQUIRE(k.identifier(ident.data(), ident.data() + ident.size()) == ident.data() + ident.size() - 1);
+
+	const std::string comment = std::string(40, 'c') + "\xC3\xA9\n";
+	REQUIRE(k.comment(comment.data(), comment.data() + comment.size()) == comment.data() + 42);
+
+	const std::string str = std::string(40, 's') + "\xC3\xA9\\\"";
+	REQUIRE(k.string(str.data(), str.data() + str.size()) == str.data() + 42);
+
+	const std::string ascii = std::string(40, 'a') + "\xC3\xA9";
+	REQUIRE(k.ascii(ascii.data(), ascii.data() + ascii.size()) == ascii.data() + 40);
+}
+
+
+// Simple one-sequence-at-a-time validator to check against
+static const char* reference_validate_utf8(const char* begin, const char* end)
+{
+	while (begin < end) {
+		const unsigned int len = utf8_sequence_length(begin, end);
+		if (len == 0)
+			return begin;
+		begin += len;
+	}
+	return end;
+}
+
+
+TEST_CASE("validate_utf8()", "[lexer]")
+{
+	const std::string valid = std::string(50, 'a') + "h\xC3\xA9llo w\xE6\xBC\xA2rld \xF0\x9F\x98\x80" + std::string(50, 'b');
+	REQUIRE(validate_utf8(valid.data(), valid.data() + valid.size()) == valid.data() + valid.size());
+
+	// Reports the first byte of the first bad sequence, wherever it is
+	const char* bad[] = {"\x80", "\xC3", "\xE6\xBC", "\xF8\x80\x80\x80\x80", "\xC3\x28"};
+	for (auto b: bad) {
+		for (size_t prefix = 0; prefix < 70; prefix += 7) {
+			const std::string s = std::string(prefix, 'x') + "\xC3\xA9" + b + std::string(40, 'y');
+			REQUIRE(validate_utf8(s.data(), s.data() + s.size()) == s.data() + prefix + 2);
+		}
+	}
+
+	// Random input
+	for (unsigned int seed = 0; seed < 64; ++seed) {
+		std::string s = random_buffer(300, seed);
+		s.insert(100, std::string(90, 'q'));
+		const char* end = s.data() + s.size();
+		for (size_t i = 0; i < s.size(); i += 13)
+			REQUIRE(validate_utf8(s.data() + i, end) == reference_validate_utf8(s.data() + i, end));
+	}
+}
@@ -0,0 +1,265 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+#include "line_index.hpp"
+#include "tokens.hpp"
+
+
+// Make sure the basic token types come out as expected
+TEST_CASE("Basic token types", "[lexer]")
+{
+	const std::string input = "fn foo[x: i32] -> i32 (x + 42)";
+	const auto tokens = lex_string(input);
+
+	const std::vector<TokenType> types {
+		K_FN, IDENTIFIER, LSQUARE, IDENTIFIER, COLON, IDENTIFIER, RSQUARE,
+		OPERATOR, IDENTIFIER, LPAREN, IDENTIFIER, OPERATOR, INTEGER_LIT, RPAREN
+	};
+
+	REQUIRE(tokens.size() == types.size());
+	for (size_t i = 0; i < types.size(); ++i) {
+		REQUIRE(tokens[i].type == types[i]);
+	}
+
+	REQUIRE(tokens[1].text == "foo");
+	REQUIRE(tokens[7].text == "->");
+	REQUIRE(tokens[12].text == "42");
+}
+
+
+// Make sure tokens start where they should, as seen through a LineIndex
+TEST_CASE("Token line and column", "[lexer]")
+{
+	const std::string input = "a\n  bb\n\tccc";
+	const auto tokens = lex_string(input);
+	const LineIndex lines(input);
+
+	REQUIRE(tokens.size() == 5);
+
+	REQUIRE(lines.position(tokens[0].text.begin()).line == 0);
+	REQUIRE(lines.position(tokens[0].text.begin()).column == 0);
+
+	REQUIRE(tokens[1].type == NEWLINE);
+	REQUIRE(lines.position(tokens[1].text.begin()).line == 0);
+	REQUIRE(lines.position(tokens[1].text.begin()).column == 1);
+
+	REQUIRE(tokens[2].text == "bb");
+	REQUIRE(lines.position(tokens[2].text.begin()).line == 1);
+	REQUIRE(lines.position(tokens[2].text.begin()).column == 2);
+
+	REQUIRE(tokens[4].text == "ccc");
+	REQUIRE(lines.position(tokens[4].text.begin()).line == 2);
+	REQUIRE(lines.position(tokens[4].text.begin()).column == 1);
+}
+
+
+// Multiple newlines, blank lines and comment-only lines should collapse
+// into a single newline token, and a backslash escapes a newline.
+TEST_CASE("Newline collapsing", "[lexer]")
+{
+	const std::string input = "a\n\n   \n# comment\n\n b\n  \\ c";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 4);
+	REQUIRE(tokens[0].text == "a");
+	REQUIRE(tokens[1].type == NEWLINE);
+	REQUIRE(tokens[2].text == "b");
+	REQUIRE(tokens[3].text == "c");
+}
+
+
+TEST_CASE("Comments and doc strings", "[lexer]")
+{
+	const std::string input = "# Not a doc string\n#: A doc string\nx";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 4);
+	REQUIRE(tokens[0].type == NEWLINE);
+	REQUIRE(tokens[1].type == DOC_STRING);
+	REQUIRE(tokens[1].text == " A doc string");
+	REQUIRE(tokens[2].type == NEWLINE);
+	REQUIRE(tokens[3].type == IDENTIFIER);
+}
+
+
+TEST_CASE("String literals", "[lexer]")
+{
+	const std::string input = "\"Hello \\\"world\\\"\" '\"raw \"quoted\" string\"'";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 2);
+
+	REQUIRE(tokens[0].type == STRING_LIT);
+	REQUIRE(tokens[0].text == "Hello \\\"world\\\"");
+
+	REQUIRE(tokens[1].type == RAW_STRING_LIT);
+	REQUIRE(tokens[1].text == "raw \"quoted\" string");
+}
+
+
+// Non-ASCII characters in strings, including right before the end
+TEST_CASE("UTF8 string literals", "[lexer]")
+{
+	const std::string input = "\"h\xC3\xA9llo w\xE6\xBC\xA2\" '\"r\xC3\xA9\xE6\xBC\xA2\"'";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 2);
+
+	REQUIRE(tokens[0].type == STRING_LIT);
+	REQUIRE(tokens[0].text == "h\xC3\xA9llo w\xE6\xBC\xA2");
+
+	REQUIRE(tokens[1].type == RAW_STRING_LIT);
+	REQUIRE(tokens[1].text == "r\xC3\xA9\xE6\xBC\xA2");
+}
+
+
+TEST_CASE("Number literals", "[lexer]")
+{
+	const std::string input = "123 4.5 6.7.8";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 3);
+	REQUIRE(tokens[0].type == INTEGER_LIT);
+	REQUIRE(tokens[1].type == FLOAT_LIT);
+	REQUIRE(tokens[2].type == UNKNOWN);
+	REQUIRE(tokens[2].text == "6.7.8");
+}
+
+
+// Generic brackets should only close generics, and should be able to
+// nest with the other brackets.
+TEST_CASE("Generic brackets", "[lexer]")
+{
+	const std::string input = "a`<b[c > d]> > e";
+	const auto tokens = lex_string(input);
+
+	const std::vector<TokenType> types {
+		IDENTIFIER, LGENERIC, IDENTIFIER, LSQUARE, IDENTIFIER, OPERATOR,
+		IDENTIFIER, RSQUARE, RGENERIC, OPERATOR, IDENTIFIER
+	};
+
+	REQUIRE(tokens.size() == types.size());
+	for (size_t i = 0; i < types.size(); ++i) {
+		REQUIRE(tokens[i].type == types[i]);
+	}
+}
+
+
+// Non-ASCII characters are identifier characters, and columns are
+// counted in bytes.
+TEST_CASE("UTF8 identifiers", "[lexer]")
+{
+	const std::string input = "h\xC3\xA9llo w\xE6\xBC\xA2rld";
+	const auto tokens = lex_string(input);
+
+	REQUIRE(tokens.size() == 2);
+	REQUIRE(tokens[0].type == IDENTIFIER);
+	REQUIRE(tokens[0].text == "h\xC3\xA9llo");
+	REQUIRE(tokens[1].type == IDENTIFIER);
+	REQUIRE(LineIndex(input).position(tokens[1].text.begin()).column == 7);
+}
+
+
+TEST_CASE("Malformed UTF8", "[lexer]")
+{
+	REQUIRE_THROWS_AS(lex_string("abc \x80 def"), const utf8_parse_error&);
+	REQUIRE_THROWS_AS(lex_string("abc \xC3"), const utf8_parse_error&);
+	REQUIRE_THROWS_AS(lex_string("abc \xE6\xBC"), const utf8_parse_error&);
+	REQUIRE_THROWS_AS(lex_string("abc \xF8\x80\x80\x80\x80"), const utf8_parse_error&);
+	REQUIRE_THROWS_AS(lex_string("# comment \xC3\x28"), const utf8_parse_error&);
+
+	// The error reports where the bad sequence is
+	size_t offset = 0;
+	try {
+		lex_string("val s = \"h\xC3\xA9llo\"\n# \xE6\xBC\xA2\xE6\xBC\n");
+	}
+	catch (const utf8_parse_error& e) {
+		offset = e.offset;
+	}
+	REQUIRE(offset == 22);
+}
+
+
+// Runs check_for_keyword() on a single identifier
+static TokenType keyword_type(const char* text)
+{
+	Token token;
+	token.type = IDENTIFIER;
+	token.text = StringSlice(text);
+	check_for_keyword(token);
+	return token.type;
+}
+
+
+TEST_CASE("Keywords", "[lexer]")
+{
+	const std::vector<std::pair<const char*, TokenType>> keywords {
+		{"namespace", K_NAMESPACE}, {"pub", K_PUB}, {"unsafe", K_UNSAFE},
+		{"const", K_CONST}, {"val", K_VAL}, {"var", K_VAR},
+		{"mut", K_MUT}, {"ref", K_REF},
+		{"fn", K_FN},
+		{"struct", K_STRUCT}, {"enum", K_ENUM}, {"union", K_UNION},
+		{"trait", K_TRAIT}, {"is", K_IS},
+		{"if", K_IF}, {"else", K_ELSE}, {"loop", K_LOOP}, {"while", K_WHILE},
+		{"until", K_UNTIL}, {"for", K_FOR}, {"in", K_IN}, {"break", K_BREAK},
+		{"continue", K_CONTINUE}, {"return", K_RETURN},
+		{"as", K_AS},
+		{"alias", K_ALIAS}, {"type", K_TYPE},
+	};
+
+	// Every keyword token type should be covered
+	REQUIRE(keywords.size() == (K_TYPE - K_NAMESPACE + 1));
+
+	for (const auto& kw: keywords) {
+		REQUIRE(keyword_type(kw.first) == kw.second);
+	}
+}
+
+
+TEST_CASE("Keyword near-misses", "[lexer]")
+{
+	const char* near_misses[] = {
+		// Prefixes and extensions of keywords
+		"namespac", "namespaces", "f", "fnn", "i", "iff", "ass", "typ", "types",
+		"_if", "if_", "continu", "continues", "returns", "unions",
+		// Wrong case
+		"Fn", "FN", "If", "Namespace", "TYPE", "Return",
+		// Same length, first and last byte as a keyword (same hash)
+		"vxl", "vzr", "fxr", "eXXm", "lxxp", "txxe", "bxxxk", "axxxs",
+		"nxxxxxxxe", "cxxxxxxe", "rxxxxn", "sxxxxt", "uxxxxe",
+		// Other identifiers
+		"x", "foo", "i32", "main", "generated_function_42", "h\xC3\xA9llo",
+	};
+
+	for (auto text: near_misses) {
+		INFO(text);
+		REQUIRE(keyword_type(text) == IDENTIFIER);
+	}
+}
+
+
+TEST_CASE("Identifiers and operators are interned", "[lexer]")
+{
+	const std::string input = "fn foo(x) = x + foo(x) + 2";
+	const auto tokens = lex_string(input);
+
+	for (const auto& t: tokens) {
+		if (t.type == IDENTIFIER || t.type == OPERATOR) {
+			REQUIRE(t.symbol != NO_SYMBOL);
+			REQUIRE(global_symbols().text(t.symbol) == t.text);
+		}
+		else {
+			REQUIRE(t.symbol == NO_SYMBOL);
+		}
+	}
+
+	// fn foo ( x ) = x + foo ( x ) + 2
+	REQUIRE(tokens[1].symbol == tokens[8].symbol);
+	REQUIRE(tokens[3].symbol == tokens[6].symbol);
+	REQUIRE(tokens[7].symbol == tokens[12].symbol);
+	REQUIRE(tokens[1].symbol != tokens[3].symbol);
+	REQUIRE(tokens[5].symbol != tokens[7].symbol);
+}
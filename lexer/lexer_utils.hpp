@@ -4,10 +4,18 @@
 #include <string>
 #include <exception>
 #include <cassert>
+#include <cstddef>
 
 class utf8_parse_error: std::exception
 {
 public:
+	size_t offset = 0; // Byte offset of the malformed sequence in the input
+
+	utf8_parse_error()
+	{}
+
+	utf8_parse_error(size_t offset): offset {offset}
+	{}
 
 // HACK: MSVC 2012/2013 doesn't support `noexcept`
 #ifdef _MSC_VER
@@ -21,34 +29,49 @@ public:
 	}
 };
 
+class source_too_large_error: std::exception
+{
+public:
+	size_t length = 0; // Length of the input in bytes
+
+	source_too_large_error()
+	{}
+
+	source_too_large_error(size_t length): length {length}
+	{}
+
+// HACK: MSVC 2012/2013 doesn't support `noexcept`
+#ifdef _MSC_VER
+	virtual const char* what() const
+	{
+#else
+	virtual const char* what() const noexcept
+	{
+#endif
+		return "Source is too large, the limit is 4GB.";
+	}
+};
+
 /**
- * Fetches a single, complete UTF8 code point, placing it in cur_c.
- * Puts an empty string in cur_c when there's nothing left to read.
- *
- * @param cur_c Pointer to a std:string to fill in with the utf8 code point.
- * @param in  Reference to a const string iterator where the parsing is to begin.
- * @param end Reference to the corresponding end iterator for the string.
+ * Returns the length in bytes of the UTF8-encoded code point that starts
+ * at in, or zero if it's malformed.
  *
- * Throws a utf8_parse_error exception on malformed utf8 input.
+ * @param in  Pointer to the first byte of the code point.  Must be before
+ *            end.
+ * @param end Pointer to the end of the input.
  */
-static inline void cur_utf8(std::string *cur_c, const std::string::const_iterator& in, const std::string::const_iterator& end)
+static inline unsigned int utf8_sequence_length(const char* in, const char* end)
 {
-	assert(cur_c != nullptr);
+	const unsigned char* c = reinterpret_cast<const unsigned char*>(in);
 
-	// Clear out cur_c
-	cur_c->clear();
-
-	if (in == end)
-		return;
-
-	const unsigned char* c = reinterpret_cast<const unsigned char*>(&(*in));
+	// ASCII fast path
+	if (c[0] < 0x80)
+		return 1;
 
 	// Determine the length of the encoded codepoint
-	int len = 0;
-	if (c[0] < 0x80)
-		len = 1;
-	else if (c[0] < 0xC0)
-		throw utf8_parse_error {}; // Malformed: continuation byte as first byte
+	unsigned int len = 0;
+	if (c[0] < 0xC0)
+		return 0; // Malformed: continuation byte as first byte
 	else if (c[0] < 0xE0)
 		len = 2;
 	else if (c[0] < 0xF0)
@@ -56,187 +79,217 @@ static inline void cur_utf8(std::string *cur_c, const std::string::const_iterato
 	else if (c[0] < 0xF8)
 		len = 4;
 	else
-		throw utf8_parse_error {}; // Malformed: current utf8 standard only allows up to four bytes
+		return 0; // Malformed: current utf8 standard only allows up to four bytes
 
-	if (len == 0 || len > (end-in))
-		throw utf8_parse_error {}; // Malformed: not enough bytes
+	if (len > static_cast<size_t>(end - in))
+		return 0; // Malformed: not enough bytes
 
-	// Copy the bytes of the codepoint to cur_c,
-	// making sure they're well-formed UTF8
-	cur_c->push_back(c[0]);
-	for (int i = 1; i < len; ++i) {
+	// Make sure the remaining bytes are continuation bytes
+	for (unsigned int i = 1; i < len; ++i) {
 		if ((c[i] & 0xC0) != 0x80)
-			throw utf8_parse_error {}; // Malformed: not a continuation byte
-
-		cur_c->push_back(c[i]);
+			return 0; // Malformed: not a continuation byte
 	}
 
 	// Success!
+	return len;
 }
 
 
 /**
- * Returns whether the given utf character is whitespace or not.
+ * Returns the length in bytes of the UTF8-encoded code point that starts
+ * at in, or zero when there's nothing left to read.
+ *
+ * Only looks at the first byte, so the input must already have been
+ * checked with validate_utf8().
+ *
+ * @param in  Pointer to the first byte of the code point.
+ * @param end Pointer to the end of the input.
  */
-static inline bool is_ws_char(const std::string& s)
+static inline unsigned int utf8_char_length(const char* in, const char* end)
 {
-	if (s.length() == 0)
-		return false;
+	if (in == end)
+		return 0;
+
+	const unsigned char c = *in;
+	if (c < 0x80)
+		return 1;
+	else if (c < 0xE0)
+		return 2;
+	else if (c < 0xF0)
+		return 3;
+	else
+		return 4;
+}
 
-	switch (s[0]) {
-		case ' ':
-		case '\t':
-			return true;
-		default:
-			break;
-	}
 
-	return false;
+////////////////////////////////////////////////////////////////
+// Character classes
+//
+// Every byte maps to a bitmask of the classes it belongs to, through a
+// table built at compile time.  None of the characters the lexer cares
+// about are outside of ASCII, so the first byte of a utf8-encoded
+// character is enough to classify it.  Every non-ASCII character is an
+// identifier character.
+////////////////////////////////////////////////////////////////
+
+enum CharClass {
+	CC_WS = 1 << 0, // Whitespace
+	CC_NL = 1 << 1, // Newline
+	CC_COMMENT = 1 << 2, // Starts a comment
+	CC_RESERVED = 1 << 3, // Reserved character, e.g. brackets and punctuation
+	CC_OP = 1 << 4, // Operator character
+	CC_DIGIT = 1 << 5, // Decimal digit
+	CC_IDENT = 1 << 6, // ASCII identifier character
+	CC_UNICODE = 1 << 7, // First byte of a non-ASCII character, always also CC_IDENT
+};
+
+static constexpr bool char_in_set(unsigned char c, const char* set)
+{
+	return *set != '\0' && (static_cast<unsigned char>(*set) == c || char_in_set(c, set + 1));
+}
+
+static constexpr unsigned char compute_char_class(unsigned char c)
+{
+	return c >= 0x80 ? (CC_UNICODE | CC_IDENT) :
+	       char_in_set(c, " \t") ? CC_WS :
+	       char_in_set(c, "\n\r") ? CC_NL :
+	       char_in_set(c, "(){}[]\\\"'`:;.,@$%") ? CC_RESERVED :
+	       char_in_set(c, "=+-*/!^&|<>?~") ? CC_OP :
+	       // Anything that isn't whitespace, reserved, or an operator
+	       // character is an identifier character
+	       (CC_IDENT | (c == '#' ? CC_COMMENT : 0) | ((c >= '0' && c <= '9') ? CC_DIGIT : 0));
 }
 
+#define CHAR_CLASS_4(i) compute_char_class(i), compute_char_class(i + 1), compute_char_class(i + 2), compute_char_class(i + 3)
+#define CHAR_CLASS_16(i) CHAR_CLASS_4(i), CHAR_CLASS_4(i + 4), CHAR_CLASS_4(i + 8), CHAR_CLASS_4(i + 12)
+#define CHAR_CLASS_64(i) CHAR_CLASS_16(i), CHAR_CLASS_16(i + 16), CHAR_CLASS_16(i + 32), CHAR_CLASS_16(i + 48)
+
+static constexpr unsigned char char_class_table[256] = {
+	CHAR_CLASS_64(0), CHAR_CLASS_64(64), CHAR_CLASS_64(128), CHAR_CLASS_64(192)
+};
+
+#undef CHAR_CLASS_4
+#undef CHAR_CLASS_16
+#undef CHAR_CLASS_64
+
 
 /**
- * Returns whether the given utf character is a newline or not.
+ * Returns the CharClass bitmask of a byte.
  */
-static inline bool is_nl_char(const std::string& s)
+static inline unsigned char char_class(unsigned char c)
 {
-	if (s.length() == 0)
-		return false;
+	return char_class_table[c];
+}
 
-	switch (s[0]) {
-		case '\n':
-		case '\r':
-			return true;
-		default:
-			break;
-	}
 
-	return false;
+////////////////////////////////////////////////////////////////
+// Character predicates
+//
+// These all operate on the first byte of a utf8-encoded character.
+////////////////////////////////////////////////////////////////
+
+/**
+ * Returns whether the given utf character is whitespace or not.
+ */
+static inline bool is_ws_char(unsigned char c)
+{
+	return char_class(c) & CC_WS;
 }
 
 
 /**
  * Returns whether the given utf character is a newline or not.
  */
-static inline bool is_comment_char(const std::string& s)
+static inline bool is_nl_char(unsigned char c)
 {
-	if (s.length() == 0)
-		return false;
+	return char_class(c) & CC_NL;
+}
 
-	if (s[0] == '#')
-		return true;
-	else
-		return false;
+
+/**
+ * Returns whether the given utf character starts a comment or not.
+ */
+static inline bool is_comment_char(unsigned char c)
+{
+	return char_class(c) & CC_COMMENT;
 }
 
 
 /**
  * Returns whether the given utf character is a reserved character or not.
  */
-static inline bool is_reserved_char(const std::string& s)
+static inline bool is_reserved_char(unsigned char c)
 {
-	if (s.length() == 0)
-		return false;
-
-	switch (s[0]) {
-		case '(':
-		case ')':
-		case '{':
-		case '}':
-		case '[':
-		case ']':
-		case '\\':
-		case '"':
-		case '\'':
-		case '`':
-		case ':':
-		case ';':
-		case '.':
-		case ',':
-		case '@':
-		case '$':
-		case '%':
-			return true;
-		default:
-			break;
-	}
-
-	return false;
+	return char_class(c) & CC_RESERVED;
 }
 
 
 /**
  * Returns whether the given utf character is an operator character or not.
  */
-static inline bool is_op_char(const std::string& s)
+static inline bool is_op_char(unsigned char c)
 {
-	if (s.length() != 1)
-		return false;
-
-	switch (s[0]) {
-		case '=':
-		case '+':
-		case '-':
-		case '*':
-		case '/':
-		case '!':
-		case '^':
-		case '&':
-		case '|':
-		case '<':
-		case '>':
-		case '?':
-		case '~':
-			return true;
-		default:
-			break;
-	}
-
-	return false;
+	return char_class(c) & CC_OP;
 }
 
 
 /**
  * Returns whether the given utf character is a numerical digit or not.
  */
-static inline bool is_digit_char(const std::string& s)
+static inline bool is_digit_char(unsigned char c)
 {
-	if (s.length() != 1)
-		return false;
-
-	switch (s[0]) {
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			return true;
-		default:
-			break;
-	}
-
-	return false;
+	return char_class(c) & CC_DIGIT;
 }
 
 
 /**
- * Returns whether the given utf character is a legal identifier character or not.
+ * Returns whether the given utf character is a legal identifier character
+ * or not.  Takes the first byte of the character.
  */
-static inline bool is_ident_char(const std::string& s)
+static inline bool is_ident_char(unsigned char c)
+{
+	return char_class(c) & CC_IDENT;
+}
+
+
+////////////////////////////////////////////////////////////////
+// std::string versions of the character predicates, kept for code
+// that holds characters as strings.  An empty string never matches.
+////////////////////////////////////////////////////////////////
+
+static inline bool is_ws_char(const std::string& s)
+{
+	return s.length() > 0 && is_ws_char(s[0]);
+}
+
+static inline bool is_nl_char(const std::string& s)
+{
+	return s.length() > 0 && is_nl_char(s[0]);
+}
+
+static inline bool is_comment_char(const std::string& s)
+{
+	return s.length() > 0 && is_comment_char(s[0]);
+}
+
+static inline bool is_reserved_char(const std::string& s)
+{
+	return s.length() > 0 && is_reserved_char(s[0]);
+}
+
+static inline bool is_op_char(const std::string& s)
 {
-	if (s.length() == 0)
-		return false;
+	return s.length() == 1 && is_op_char(s[0]);
+}
 
-	// Anything that isn't whitespace, reserved, or an operator character
-	if (!is_ws_char(s) && !is_nl_char(s) && !is_reserved_char(s) && !is_op_char(s))
-		return true;
+static inline bool is_digit_char(const std::string& s)
+{
+	return s.length() == 1 && is_digit_char(s[0]);
+}
 
-	return false;
+static inline bool is_ident_char(const std::string& s)
+{
+	return s.length() > 0 && is_ident_char(s[0]);
 }
 
 #endif // LEXER_UTILS_HPP
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "catch.hpp"
+
+#include <cstring>
+#include <string>
+
+#include "lexer_utils.hpp"
+
+
+// Straightforward reference versions of the predicates, to check the
+// character class table against.
+static bool in_set(unsigned char c, const char* set)
+{
+	return c != 0 && std::strchr(set, c) != nullptr;
+}
+
+static bool reference_is_ident(unsigned char c)
+{
+	return !in_set(c, " \t\n\r(){}[]\\\"'`:;.,@$%=+-*/!^&|<>?~");
+}
+
+
+TEST_CASE("Character class table matches the character sets", "[lexer]")
+{
+	for (unsigned int i = 0; i < 256; ++i) {
+		const unsigned char c = static_cast<unsigned char>(i);
+		INFO("byte " << i);
+
+		REQUIRE(is_ws_char(c) == in_set(c, " \t"));
+		REQUIRE(is_nl_char(c) == in_set(c, "\n\r"));
+		REQUIRE(is_comment_char(c) == (c == '#'));
+		REQUIRE(is_reserved_char(c) == in_set(c, "(){}[]\\\"'`:;.,@$%"));
+		REQUIRE(is_op_char(c) == in_set(c, "=+-*/!^&|<>?~"));
+		REQUIRE(is_digit_char(c) == (c >= '0' && c <= '9'));
+		REQUIRE(is_ident_char(c) == reference_is_ident(c));
+		REQUIRE(((char_class(c) & CC_UNICODE) != 0) == (c >= 0x80));
+	}
+}
+
+
+TEST_CASE("Character predicates on strings", "[lexer]")
+{
+	REQUIRE(is_ws_char(std::string(" ")));
+	REQUIRE(is_nl_char(std::string("\r\n")));
+	REQUIRE(is_op_char(std::string("+")));
+	REQUIRE(is_reserved_char(std::string("(")));
+	REQUIRE(is_digit_char(std::string("7")));
+	REQUIRE(is_ident_char(std::string("_")));
+	REQUIRE(is_ident_char(std::string("\xC3\xA9"))); // é
+	REQUIRE(is_ident_char(std::string("\xE2\x88\x91"))); // ∑
+
+	REQUIRE_FALSE(is_ws_char(std::string()));
+	REQUIRE_FALSE(is_ident_char(std::string()));
+	REQUIRE_FALSE(is_ident_char(std::string("+")));
+	REQUIRE_FALSE(is_digit_char(std::string("a")));
+}
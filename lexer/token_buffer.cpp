@@ -0,0 +1,68 @@
+#include "token_buffer.hpp"
+#include "lexer.hpp"
+
+
+// Checked before anything else is initialized, since the line index has
+// 32-bit offsets too
+static size_t checked_length(const std::string& input)
+{
+	if (input.size() > TokenBuffer::MAX_SOURCE_LENGTH)
+		throw source_too_large_error {input.size()};
+	return input.size();
+}
+
+
+TokenBuffer::TokenBuffer(const std::string& input): source {input.data()}, source_length {checked_length(input)}, line_index {input}
+{
+	Lexer lexer(input.data(), input.data() + input.size());
+	fill(lexer);
+}
+
+
+TokenBuffer::TokenBuffer(const std::string& input, DiagnosticEngine& diagnostics): source {input.data()}, source_length {checked_length(input)}, line_index {input}
+{
+	Lexer lexer(input.data(), input.data() + input.size(), diagnostics);
+	fill(lexer);
+}
+
+
+void TokenBuffer::fill(Lexer& lexer)
+{
+	// Source code averages somewhere around one token per eight bytes,
+	// so this usually avoids most of the regrowth.
+	const size_t estimate = source_length / 8 + 1;
+	types.reserve(estimate);
+	payloads.reserve(estimate);
+	begins.reserve(estimate);
+	ends.reserve(estimate);
+
+	while (true) {
+		const Token t = lexer.lex_token();
+
+		types.push_back(static_cast<uint8_t>(t.type));
+		switch (t.type) {
+			case INTEGER_LIT:
+			case FLOAT_LIT:
+				payloads.push_back(static_cast<uint32_t>(number_values.size()));
+				number_values.push_back(t.value);
+				break;
+			case STRING_LIT:
+				payloads.push_back(t.value.string);
+				break;
+			default:
+				payloads.push_back(t.symbol);
+				break;
+		}
+		begins.push_back(static_cast<uint32_t>(t.text.begin() - source));
+		ends.push_back(static_cast<uint32_t>(t.text.end() - source));
+
+		if (t.type == LEX_EOF)
+			break;
+	}
+
+	types.shrink_to_fit();
+	payloads.shrink_to_fit();
+	number_values.shrink_to_fit();
+	begins.shrink_to_fit();
+	ends.shrink_to_fit();
+}
@@ -0,0 +1,182 @@
+#ifndef TOKEN_BUFFER_HPP
+#define TOKEN_BUFFER_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "diagnostics.hpp"
+#include "lexer_utils.hpp"
+#include "line_index.hpp"
+#include "string_slice.hpp"
+#include "symbol_table.hpp"
+#include "tokens.hpp"
+
+class Lexer;
+
+
+/**
+ * A compact, fully lexed token sequence.
+ *
+ * Rather than an array of Tokens (32 bytes each), this stores the tokens
+ * as a structure of arrays: a byte for the type, a 32-bit payload, and
+ * two 32-bit offsets into the source text for the start and end.  That's
+ * 13 bytes per token, and the type array on its own is dense enough that
+ * scans over it (e.g. skipping newlines) touch very little memory.
+ *
+ * The payload is the symbol ID for identifiers and operators, the string
+ * ID for string literals (see TokenValue), and an index into a separate array of values
+ * for number literals, which are too few to be worth a full-width column.
+ *
+ * Line and column numbers aren't stored at all.  They're computed on
+ * demand through a LineIndex, which is itself only built the first time
+ * a line or column is asked for.  lines() can be shared between threads.
+ *
+ * The buffer doesn't own the input, which must outlive it.  The last
+ * token is always LEX_EOF.
+ */
+class TokenBuffer
+{
+	const char* source;
+	size_t source_length;
+
+	std::vector<uint8_t> types;
+	std::vector<uint32_t> payloads;
+	std::vector<TokenValue> number_values;
+	std::vector<uint32_t> begins;
+	std::vector<uint32_t> ends;
+
+	LineIndex line_index;
+
+	void fill(Lexer& lexer);
+
+public:
+	// Token offsets are 32 bits, so this is the largest source that fits
+	static const size_t MAX_SOURCE_LENGTH = UINT32_MAX;
+
+	// Throws a utf8_parse_error on malformed utf8.  Both constructors
+	// throw a source_too_large_error if input is over MAX_SOURCE_LENGTH.
+	TokenBuffer(const std::string& input);
+
+	// Reports malformed utf8 and lexing errors to diagnostics instead
+	TokenBuffer(const std::string& input, DiagnosticEngine& diagnostics);
+
+	// Non-copyable, since it would be easy to do by accident and the
+	// arrays can be large.
+	TokenBuffer(const TokenBuffer& other) = delete;
+	TokenBuffer& operator=(const TokenBuffer& other) = delete;
+
+
+	// Number of tokens, including the final LEX_EOF
+	size_t size() const
+	{
+		return types.size();
+	}
+
+	TokenType type(size_t i) const
+	{
+		return static_cast<TokenType>(types[i]);
+	}
+
+	uint32_t symbol(size_t i) const
+	{
+		return (types[i] == IDENTIFIER || types[i] == OPERATOR) ? payloads[i] : NO_SYMBOL;
+	}
+
+	// The decoded value of a literal token
+	TokenValue value(size_t i) const
+	{
+		TokenValue v = {0};
+		if (types[i] == INTEGER_LIT || types[i] == FLOAT_LIT)
+			v = number_values[payloads[i]];
+		else if (types[i] == STRING_LIT)
+			v.string = payloads[i];
+		return v;
+	}
+
+	StringSlice text(size_t i) const
+	{
+		return StringSlice(source + begins[i], source + ends[i]);
+	}
+
+	// Line and column of the start of the token
+	unsigned int line(size_t i) const
+	{
+		return line_index.line_of(source + begins[i]);
+	}
+
+	unsigned int column(size_t i) const
+	{
+		return line_index.position(source + begins[i]).column;
+	}
+
+	// Assembles a full Token
+	Token token(size_t i) const
+	{
+		Token t;
+		t.type = type(i);
+		t.symbol = symbol(i);
+		t.value = value(i);
+		t.text = text(i);
+		return t;
+	}
+
+	// The whole source text
+	StringSlice source_text() const
+	{
+		return StringSlice(source, source + source_length);
+	}
+
+	const LineIndex& lines() const
+	{
+		return line_index;
+	}
+
+
+	/**
+	 * Returns the index of the first token at or after i whose type is
+	 * neither a nor b.  Only looks at the type array.
+	 */
+	size_t skip(size_t i, TokenType a, TokenType b) const
+	{
+		const uint8_t* t = types.data();
+		const size_t n = types.size() - 1; // The final LEX_EOF always stops the scan
+		while (i < n && (t[i] == a || t[i] == b))
+			++i;
+		return i;
+	}
+
+
+	/**
+	 * Given the index of a "(", returns the index just past its matching
+	 * ")", or of the final LEX_EOF if it's never closed.  Only looks at
+	 * the type array.
+	 */
+	size_t skip_parens(size_t i) const
+	{
+		assert(types[i] == LPAREN);
+
+		const uint8_t* t = types.data();
+		const size_t n = types.size() - 1;
+		size_t depth = 0;
+		for (; i < n; ++i) {
+			if (t[i] == LPAREN)
+				++depth;
+			else if (t[i] == RPAREN && --depth == 0)
+				return i + 1;
+		}
+		return n;
+	}
+
+
+	// Bytes of memory used by the token arrays, not counting the line
+	// index.
+	size_t memory_usage() const
+	{
+		return types.capacity() * sizeof(uint8_t) + (payloads.capacity() + begins.capacity() + ends.capacity()) * sizeof(uint32_t) + number_values.capacity() * sizeof(TokenValue);
+	}
+};
+
+
+#endif // TOKEN_BUFFER_HPP
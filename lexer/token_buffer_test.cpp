@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+#include "lexer.hpp"
+#include "token_buffer.hpp"
+
+
+// Should match what the lexer produces directly, and the lines and
+// columns should match a simple count.
+TEST_CASE("TokenBuffer matches lex_string()", "[token_buffer]")
+{
+	const std::string input = generate_corpus(50000, true);
+	const auto tokens = lex_string(input);
+	const TokenBuffer buffer(input);
+
+	REQUIRE(buffer.size() == tokens.size() + 1);
+	REQUIRE(buffer.type(tokens.size()) == LEX_EOF);
+
+	unsigned int line = 0;
+	const char* line_start = input.data();
+	const char* itr = input.data();
+	for (size_t i = 0; i < tokens.size(); ++i) {
+		REQUIRE(buffer.type(i) == tokens[i].type);
+		REQUIRE(buffer.symbol(i) == tokens[i].symbol);
+		REQUIRE(buffer.value(i).integer == tokens[i].value.integer);
+		REQUIRE(buffer.text(i).begin() == tokens[i].text.begin());
+		REQUIRE(buffer.text(i).end() == tokens[i].text.end());
+
+		for (; itr < tokens[i].text.begin(); ++itr) {
+			if (*itr == '\n') {
+				++line;
+				line_start = itr + 1;
+			}
+		}
+		REQUIRE(buffer.line(i) == line);
+		REQUIRE(buffer.column(i) == (tokens[i].text.begin() - line_start));
+	}
+}
+
+
+TEST_CASE("TokenBuffer lines and columns", "[token_buffer]")
+{
+	const std::string input = "a\n  bc\n\n\td # e\n'''r\nr''' f";
+	const TokenBuffer buffer(input);
+
+	// The newline after "a" belongs to the first line
+	REQUIRE(buffer.type(1) == NEWLINE);
+	REQUIRE(buffer.line(1) == 0);
+	REQUIRE(buffer.column(1) == 1);
+
+	// The raw string literal spans lines, "f" is after it
+	const size_t last = buffer.size() - 2;
+	REQUIRE(buffer.text(last) == "f");
+	REQUIRE(buffer.line(last) == 5);
+	REQUIRE(buffer.column(last) == 5);
+}
+
+
+TEST_CASE("TokenBuffer skip", "[token_buffer]")
+{
+	const std::string input = "a\n\n#: doc\n\nb\n";
+	const TokenBuffer buffer(input);
+
+	REQUIRE(buffer.skip(0, NEWLINE, NEWLINE) == 0);
+	REQUIRE(buffer.type(buffer.skip(1, NEWLINE, NEWLINE)) == DOC_STRING);
+	REQUIRE(buffer.text(buffer.skip(1, NEWLINE, DOC_STRING)) == "b");
+
+	// Never skips past the end
+	REQUIRE(buffer.skip(buffer.size() - 2, NEWLINE, NEWLINE) == buffer.size() - 1);
+	REQUIRE(buffer.skip(buffer.size() - 1, LEX_EOF, LEX_EOF) == buffer.size() - 1);
+}
+
+
+TEST_CASE("TokenBuffer is smaller than a token vector", "[token_buffer]")
+{
+	const std::string input = generate_corpus(50000, true);
+	const auto tokens = lex_string(input);
+	const TokenBuffer buffer(input);
+
+	// A little over 13 bytes per token vs 32
+	const size_t buffer_bytes = buffer.memory_usage() * 2;
+	REQUIRE(buffer_bytes < tokens.size() * sizeof(Token));
+}
@@ -0,0 +1,212 @@
+#ifndef TOKEN_STREAM_HPP
+#define TOKEN_STREAM_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <string>
+
+#include "lexer.hpp"
+#include "token_buffer.hpp"
+#include "tokens.hpp"
+
+
+/**
+ * A stream of tokens that are lexed lazily, as the consumer (i.e. the
+ * parser) asks for them.
+ *
+ * Only tokens that can still be reached are kept around: the current
+ * token, the one before it, and any that have been peeked at.  So memory
+ * use is proportional to lookahead distance rather than the size of the
+ * input.
+ *
+ * A stream can also be read from an already lexed TokenBuffer, in which
+ * case skip() can scan the buffer's type array directly instead of
+ * assembling each skipped token.
+ *
+ * The interface mimics an iterator over the tokens, which is how the
+ * parser was originally written.  Once the end of the input is reached,
+ * the stream keeps returning LEX_EOF tokens.
+ */
+class TokenStream
+{
+	Lexer lexer;
+	const TokenBuffer* token_buffer = nullptr; // If set, tokens come from here instead of the lexer
+	StringSlice source; // The full input text
+	std::deque<Token> buffer; // Buffered tokens, starting at index buffer_start
+	size_t buffer_start = 0;
+	size_t pos = 0; // Index of the current token
+
+public:
+	TokenStream(const std::string& input): lexer {input.data(), input.data() + input.size()}, source {input.data(), input.data() + input.size()}
+	{}
+
+	TokenStream(const TokenBuffer& tokens): lexer {nullptr, nullptr}, token_buffer {&tokens}, source {tokens.source_text()}
+	{}
+
+	// Starts partway through a TokenBuffer, at token index start
+	TokenStream(const TokenBuffer& tokens, size_t start): lexer {nullptr, nullptr}, token_buffer {&tokens}, source {tokens.source_text()}, buffer_start {start > 0 ? start - 1 : 0}, pos {start}
+	{}
+
+	// Non-copyable, since the buffered tokens are only meaningful for
+	// a single lexer.
+	TokenStream(const TokenStream& other) = delete;
+	TokenStream& operator=(const TokenStream& other) = delete;
+
+
+	// The current token
+	const Token& operator*()
+	{
+		return token_at(pos);
+	}
+
+	const Token* operator->()
+	{
+		return &token_at(pos);
+	}
+
+	// Peeks n tokens ahead of the current token
+	const Token& operator[](size_t n)
+	{
+		return token_at(pos + n);
+	}
+
+	// The token just before the current one
+	const Token& prev()
+	{
+		assert(pos > 0);
+		return token_at(pos - 1);
+	}
+
+	// Advances to the next token
+	TokenStream& operator++()
+	{
+		++pos;
+		trim();
+		return *this;
+	}
+
+
+	// Advances past any run of tokens of the given types
+	void skip(TokenType a, TokenType b)
+	{
+		if (token_buffer != nullptr) {
+			const size_t next = token_buffer->skip(pos, a, b);
+			if (next != pos) {
+				pos = next;
+				trim();
+			}
+			return;
+		}
+
+		while (token_at(pos).type == a || token_at(pos).type == b)
+			++*this;
+	}
+
+	void skip(TokenType t)
+	{
+		skip(t, t);
+	}
+
+
+	// Advances past the parenthesized group that starts at the current
+	// "(", or to the end of input if it's never closed
+	void skip_parens()
+	{
+		assert(token_at(pos).type == LPAREN);
+
+		if (token_buffer != nullptr) {
+			pos = token_buffer->skip_parens(pos);
+			trim();
+			return;
+		}
+
+		size_t depth = 0;
+		do {
+			if (token_at(pos).type == LPAREN)
+				++depth;
+			else if (token_at(pos).type == RPAREN)
+				--depth;
+			++*this;
+		} while (depth > 0 && token_at(pos).type != LEX_EOF);
+	}
+
+
+	// Jumps to token index i, in either direction.  Only for streams
+	// read from a TokenBuffer, since anything else would mean lexing
+	// everything in between.
+	void seek(size_t i)
+	{
+		assert(token_buffer != nullptr);
+		buffer.clear();
+		buffer_start = i > 0 ? i - 1 : 0;
+		pos = i;
+	}
+
+
+	// The whole text being tokenized
+	StringSlice source_text() const
+	{
+		return source;
+	}
+
+
+	// A line index over the source.  When reading from a TokenBuffer it
+	// shares the buffer's, so the lines are only ever found once.
+	LineIndex lines() const
+	{
+		if (token_buffer != nullptr)
+			return token_buffer->lines();
+		return LineIndex(source.begin(), source.end());
+	}
+
+
+	// Index of the current token from the start of the input
+	size_t position() const
+	{
+		return pos;
+	}
+
+
+	// Number of tokens currently held in memory
+	size_t buffered() const
+	{
+		return buffer.size();
+	}
+
+
+private:
+	const Token& token_at(size_t i)
+	{
+		assert(i >= buffer_start);
+
+		while ((buffer_start + buffer.size()) <= i) {
+			if (token_buffer != nullptr)
+				buffer.push_back(token_buffer->token(std::min(buffer_start + buffer.size(), token_buffer->size() - 1)));
+			else
+				buffer.push_back(lexer.lex_token());
+		}
+
+		return buffer[i - buffer_start];
+	}
+
+	// Drops tokens that can no longer be reached.  That's everything before
+	// the token preceding the current position, which prev() needs.
+	void trim()
+	{
+		const size_t keep_from = pos > 0 ? pos - 1 : 0;
+
+		while (buffer_start < keep_from && !buffer.empty()) {
+			buffer.pop_front();
+			++buffer_start;
+		}
+
+		// Tokens from a buffer can be fetched by index, so after skip()
+		// jumps ahead there's no need to fill in the ones in between.
+		if (buffer.empty() && token_buffer != nullptr)
+			buffer_start = keep_from;
+	}
+};
+
+
+#endif // TOKEN_STREAM_HPP
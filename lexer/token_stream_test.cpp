@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+#include "lexer.hpp"
+#include "test_utils.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+// The stream should produce exactly the same tokens as lex_string(),
+// followed by LEX_EOF forever.
+TEST_CASE("TokenStream matches lex_string()", "[token_stream]")
+{
+	const std::string input = generate_corpus(20000, true);
+	const auto tokens = lex_string(input);
+
+	TokenStream stream(input);
+	for (const auto& t: tokens) {
+		REQUIRE(same_token(*stream, t));
+		++stream;
+	}
+
+	REQUIRE(stream->type == LEX_EOF);
+	REQUIRE(stream[1].type == LEX_EOF);
+	++stream;
+	REQUIRE(stream->type == LEX_EOF);
+}
+
+
+TEST_CASE("TokenStream lookahead and previous token", "[token_stream]")
+{
+	const std::string input = "a b c d";
+	TokenStream stream(input);
+
+	REQUIRE(stream->text == "a");
+	REQUIRE(stream[1].text == "b");
+	REQUIRE(stream[3].text == "d");
+
+	++stream;
+	REQUIRE(stream->text == "b");
+	REQUIRE(stream.prev().text == "a");
+}
+
+
+// Only a bounded number of tokens should be held in memory no matter how
+// long the input is.
+TEST_CASE("TokenStream memory is bounded", "[token_stream]")
+{
+	const std::string input = generate_corpus(100000);
+	TokenStream stream(input);
+
+	size_t max_buffered = 0;
+	while (stream->type != LEX_EOF) {
+		stream[1];
+		if (stream.buffered() > max_buffered)
+			max_buffered = stream.buffered();
+		++stream;
+	}
+
+	REQUIRE(max_buffered <= 3);
+}
+
+
+TEST_CASE("TokenStream from a TokenBuffer", "[token_stream]")
+{
+	const std::string input = generate_corpus(20000, true);
+	const auto tokens = lex_string(input);
+	const TokenBuffer buffer(input);
+
+	TokenStream stream(buffer);
+	for (const auto& t: tokens) {
+		REQUIRE(same_token(*stream, t));
+		++stream;
+	}
+
+	REQUIRE(stream->type == LEX_EOF);
+	REQUIRE(stream[1].type == LEX_EOF);
+	++stream;
+	REQUIRE(stream->type == LEX_EOF);
+}
+
+
+TEST_CASE("TokenStream starting partway through a TokenBuffer", "[token_stream]")
+{
+	const std::string input = "a b\nc d\n";
+	const TokenBuffer buffer(input);
+
+	TokenStream stream(buffer, 3);
+	REQUIRE(stream.position() == 3);
+	REQUIRE(stream->text == "c");
+	REQUIRE(stream.prev().type == NEWLINE);
+	++stream;
+	REQUIRE(stream.position() == 4);
+	REQUIRE(stream->text == "d");
+}
+
+
+TEST_CASE("TokenStream seek", "[token_stream]")
+{
+	const std::string input = "a b\nc d\n";
+	const TokenBuffer buffer(input);
+
+	TokenStream stream(buffer);
+	stream.seek(4);
+	REQUIRE(stream->text == "d");
+	REQUIRE(stream.prev().text == "c");
+
+	stream.seek(1);
+	REQUIRE(stream->text == "b");
+	REQUIRE(stream.prev().text == "a");
+	++stream;
+	REQUIRE(stream->type == NEWLINE);
+
+	stream.seek(0);
+	REQUIRE(stream->text == "a");
+}
+
+
+// skip() should land in the same place with and without a buffer
+TEST_CASE("TokenStream skip", "[token_stream]")
+{
+	const std::string input = "a\n\n#: doc\n\nb c\n\nd\n";
+	const TokenBuffer buffer(input);
+	TokenStream s1(input);
+	TokenStream s2(buffer);
+
+	for (auto s: {&s1, &s2}) {
+		s->skip(NEWLINE);
+		REQUIRE((*s)->text == "a");
+		++*s;
+		s->skip(NEWLINE);
+		REQUIRE((*s)->type == DOC_STRING);
+		s->skip(DOC_STRING, NEWLINE);
+		REQUIRE((*s)->text == "b");
+
+		++*s;
+		REQUIRE((*s)->text == "c");
+		REQUIRE(s->prev().text == "b");
+
+		++*s;
+		s->skip(NEWLINE);
+		REQUIRE((*s)->text == "d");
+		REQUIRE(s->prev().type == NEWLINE);
+		++*s;
+		s->skip(NEWLINE);
+		REQUIRE((*s)->type == LEX_EOF);
+	}
+}
+
+
+TEST_CASE("TokenStream skip_parens", "[token_stream]")
+{
+	const std::string input = "a (b (c\n) [d] (e)) f (g (h";
+	const TokenBuffer buffer(input);
+	TokenStream s1(input);
+	TokenStream s2(buffer);
+
+	for (auto s: {&s1, &s2}) {
+		++*s;
+		s->skip_parens();
+		REQUIRE((*s)->text == "f");
+		REQUIRE(s->prev().text == ")");
+
+		++*s;
+		s->skip_parens();
+		REQUIRE((*s)->type == LEX_EOF);
+	}
+}
\ No newline at end of file
@@ -1,23 +1,104 @@
 #include "config.h"
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
+#include "diagnostics.hpp"
 #include "lexer.hpp"
+#include "line_index.hpp"
+#include "token_buffer.hpp"
 #include "parser.hpp"
 #include "ast.hpp"
 #include "c_gen.hpp"
+#include "symbol_table.hpp"
+
+
+// Prints the arena statistics at the end of a compilation phase, for
+// --mem-stats
+static void print_mem_stats(const char* phase, const AST* ast)
+{
+#ifdef MEMORY_ARENA_STATS
+	std::cout << "Memory after " << phase << ":\n";
+	std::cout << "  Symbols:\n";
+	global_symbols().text_arena().print_stats(std::cout);
+	std::cout << "  String literals:\n";
+	global_strings().text_arena().print_stats(std::cout);
+	if (ast != nullptr) {
+		std::cout << "  AST:\n";
+		ast->store.print_stats(std::cout);
+		for (const auto& store: ast->spliced_stores)
+			store.print_stats(std::cout);
+	}
+	std::cout << std::endl;
+#endif
+}
+
+
+// Prints the line and signature of each top-level declaration, with
+// whitespace collapsed and function bodies left out, for --outline
+static void print_outline(const AST& ast, const TokenBuffer& tokens)
+{
+	for (auto decl: ast.root->declarations) {
+		const char* begin = decl->code.text.begin();
+		const char* end = decl->code.text.end();
+		auto fn = node_cast<FuncLiteralNode>(decl->initializer);
+		if (fn != nullptr && fn->deferred != nullptr)
+			end = tokens.text(fn->body_begin).begin();
+
+		std::string signature;
+		for (const char* p = begin; p < end; ++p) {
+			if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+				if (!signature.empty() && signature.back() != ' ')
+					signature += ' ';
+			}
+			else {
+				signature += *p;
+			}
+		}
+		if (!signature.empty() && signature.back() == ' ')
+			signature.pop_back();
+
+		std::cout << "L" << ast.lines.line_of(begin) + 1 << ":\t" << signature << "\n";
+	}
+}
+
 
 int main(int argc, char** argv)
 {
 	InitBuiltins();
 	std::cout << "Rune v" << VERSION_MAJOR << "." << VERSION_MINOR << "." << VERSION_PATCH << "\n";
 
+	// Options come before the input and output files
+	bool mem_stats = false;
+	bool outline = false; // Only list the declarations, without parsing function bodies
+	while (argc > 1 && std::strncmp(argv[1], "--", 2) == 0) {
+		if (std::strcmp(argv[1], "--mem-stats") == 0) {
+			mem_stats = true;
+		}
+		else if (std::strcmp(argv[1], "--outline") == 0) {
+			outline = true;
+		}
+		else {
+			std::cout << "Unknown option '" << argv[1] << "'.\n";
+			return 1;
+		}
+		--argc;
+		++argv;
+	}
+
 	if (argc < 2) {
 		std::cout << "You must specify a file to compile.\n";
 		return 0;
 	}
 
+#ifndef MEMORY_ARENA_STATS
+	if (mem_stats) {
+		std::cout << "--mem-stats needs a build with RUNE_MEM_STATS enabled.\n";
+		return 1;
+	}
+#endif
+
 
 	std::cout << "Reading file..." << std::endl;
 
@@ -32,20 +113,51 @@ int main(int argc, char** argv)
 		f.close();
 	}
 
+	if (contents.size() > TokenBuffer::MAX_SOURCE_LENGTH) {
+		std::cout << "'" << argv[1] << "' is too large, the limit is 4GB.\n";
+		return 1;
+	}
+
+	DiagnosticEngine diagnostics;
+
 	std::cout << "Lexing..." << std::endl;
-	auto tokens = lex_string(contents);
-	for (auto& t: tokens) {
-		std::cout << "[L" << t.line + 1 << ", C" << t.column << ", " << t.type << "]:\t" << " " << t.text << std::endl;
+	const TokenBuffer token_buffer(contents, diagnostics);
+
+	if (outline) {
+		std::cout << "Outlining..." << std::endl;
+		AST ast = parse_tokens_outline(token_buffer, diagnostics);
+		print_outline(ast, token_buffer);
+
+		if (mem_stats)
+			print_mem_stats("outlining", &ast);
+
+		if (diagnostics.has_errors()) {
+			diagnostics.print(std::cout, argv[1], token_buffer.lines());
+			std::cout << diagnostics.error_count() << (diagnostics.error_count() == 1 ? " error.\n" : " errors.\n");
+			return 1;
+		}
+		return 0;
 	}
 
-	AST ast;
-	try {
-		std::cout << "Parsing..." << std::endl;
-		ast = parse_tokens(argv[1], tokens);
-		ast.print();
+	for (size_t i = 0; token_buffer.type(i) != LEX_EOF; ++i) {
+		std::cout << "[L" << token_buffer.line(i) + 1 << ", C" << token_buffer.column(i) << ", " << token_buffer.type(i) << "]:\t" << " " << token_buffer.text(i) << std::endl;
 	}
-	catch (ParseError e) {
-		throw e;
+
+	if (mem_stats)
+		print_mem_stats("lexing", nullptr);
+
+	std::cout << "Parsing..." << std::endl;
+	AST ast = parse_tokens_parallel(token_buffer, diagnostics);
+	ast.print();
+
+	if (mem_stats)
+		print_mem_stats("parsing", &ast);
+
+	// Report everything found so far at once
+	if (diagnostics.has_errors()) {
+		diagnostics.print(std::cout, argv[1], token_buffer.lines());
+		std::cout << diagnostics.error_count() << (diagnostics.error_count() == 1 ? " error.\n" : " errors.\n");
+		return 1;
 	}
 
 	ast.link_references();
@@ -54,6 +166,9 @@ int main(int argc, char** argv)
 		printf("Shame on you!");
 	}
 
+	if (mem_stats)
+		print_mem_stats("linking and type checking", &ast);
+
 	// Write C output
 	if (argc > 2) {
 		std::ofstream f_out(argv[2], std::ios::out | std::ios::binary);
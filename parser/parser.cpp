@@ -3,23 +3,20 @@
 #include "type.hpp"
 
 
-AST parse_tokens(const char* file_path, const std::vector<Token>& tokens)
+AST parse_tokens(TokenStream& tokens, DiagnosticEngine& diagnostics)
 {
-	Parser parser(file_path, tokens);
+	Parser parser(tokens, diagnostics);
 
 	return parser.parse();
 }
 
 
-Parser::Parser(std::string file_path, const std::vector<Token>& tokens): file_path {file_path}, begin {tokens.cbegin()}, end {tokens.cend()}, token_iter {tokens.cbegin()}
+Parser::Parser(TokenStream& tokens, DiagnosticEngine& diagnostics): token_iter {tokens}, diagnostics {diagnostics}
 {
 	// Build operator precidence map
 	// Note that this is only for function-like binary operators.
 	// Non-function-like operators such as . have their own rules.
 	// Unary operators always bind more tightly than binary operators.
-	binary_op_list.reserve(256); // Make sure we have enough space to avoid iterator invalidation
-	binary_op_list.append(" "); // To get it started, so that add_op_prec()'s logic works
-
 	add_op_prec("*", 100); // Multiply
 	add_op_prec("/", 100); // Divide
 	add_op_prec("//", 100); // Modulus/remainder
@@ -53,55 +50,111 @@ Parser::Parser(std::string file_path, const std::vector<Token>& tokens): file_pa
 
 
 AST Parser::parse()
+{
+	AST result = parse_range(static_cast<size_t>(-1));
+	result.lines = token_iter.lines();
+	return result;
+}
+
+
+AST Parser::parse_range(size_t end)
 {
 	ast.root = ast.store.alloc<NamespaceNode>();
-	ast.root->code = *begin;
-	ast.root->code.text.set_end(end->text.end());
+	ast.root->code = *token_iter;
 
 	std::vector<NamespaceNode*> namespaces;
-	std::vector<DeclNode*> declarations;
+	ScratchList<DeclNode*> declarations(scratch);
 
 	// Iterate over the tokens and collect all top-level
 	// declarations and namespaces
-	while (token_iter < end) {
+	while (token_iter->type != LEX_EOF) {
 		skip_docstrings_and_newlines();
-
-		// Call the appropriate parsing function for the token type
-		switch (token_iter->type) {
-			// Declarations
-			case K_CONST:
-			case K_VAL:
-			case K_VAR:
-			case K_FN:
-			case K_STRUCT:
-			case K_TYPE: {
-				declarations.push_back(parse_declaration());
-				break;
-			}
-
-			case K_NAMESPACE:
-				// TODO
-				parsing_error(*token_iter, "TODO: namespaces not yet implemented.");
-				break;
-
-			case LEX_EOF:
-				goto done;
-
-			// Something else, not allowed at this level
-			default: {
-				// Error
-				parsing_error(*token_iter, "Only declarations are allowed at the namespace level");
+		if (token_iter.position() >= end)
+			break;
+
+		const size_t scope_depth = fn_scope.depth();
+		const auto store_mark = ast.store.mark();
+		try {
+			// Call the appropriate parsing function for the token type
+			switch (token_iter->type) {
+				// Declarations
+				case K_CONST:
+				case K_VAL:
+				case K_VAR:
+				case K_FN:
+				case K_STRUCT:
+				case K_TYPE: {
+					declarations.push_back(parse_declaration());
+					break;
+				}
+
+				case K_NAMESPACE:
+					// TODO
+					parsing_error(*token_iter, "TODO: namespaces not yet implemented.");
+					break;
+
+				case LEX_EOF:
+					goto done;
+
+				// Something else, not allowed at this level
+				default: {
+					// Error
+					parsing_error(*token_iter, "Only declarations are allowed at the namespace level");
+				}
 			}
 		}
-
+		catch (const ParseError&) {
+			// Already reported, carry on with the next declaration.  Nothing
+			// allocated for the broken one is referenced anymore.
+			restore_scope_depth(scope_depth);
+			ast.store.rewind(store_mark);
+			synchronize(false);
+		}
 	}
 
 done:
+	ast.root->code.text.set_end(token_iter->text.end());
 
 	// Move lists of declarations and namespaces into root
 	ast.root->namespaces = ast.store.alloc_from_iters(namespaces.begin(), namespaces.end());
-	ast.root->declarations = ast.store.alloc_from_iters(declarations.begin(), declarations.end());
+	ast.root->declarations = declarations.commit(ast.store);
 
 	// Return the AST
 	return std::move(ast);
 }
+
+
+void Parser::synchronize(bool in_scope)
+{
+	int depth = 0; // Bracket nesting, relative to where the error was
+	while (token_iter->type != LEX_EOF) {
+		switch (token_iter->type) {
+			case NEWLINE:
+				if (depth == 0)
+					return;
+				break;
+
+			case LPAREN:
+			case LSQUARE:
+			case LCURLY:
+				++depth;
+				break;
+
+			case RPAREN:
+				if (depth == 0 && in_scope)
+					return;
+				depth = depth > 0 ? depth - 1 : 0;
+				break;
+
+			case RSQUARE:
+			case RCURLY:
+				depth = depth > 0 ? depth - 1 : 0;
+				break;
+
+			default:
+				break;
+		}
+
+		++token_iter;
+	}
+}
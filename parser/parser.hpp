@@ -3,95 +3,149 @@
 
 #include "builtins.hpp"
 #include "tokens.hpp"
+#include "token_stream.hpp"
 #include "ast.hpp"
+#include "diagnostics.hpp"
 #include "string_slice.hpp"
 #include "scope_stack.hpp"
+#include "scratch_stack.hpp"
+#include "thread_pool.hpp"
 
 #include <cassert>
 #include <iostream>
-#include <exception>
 #include <string>
 #include <cstring>
-#include <sstream>
 #include <unordered_map>
 #include <vector>
 
 
 
 
-AST parse_tokens(const char* file_path, const std::vector<Token>& tokens);
+/**
+ * Parses a token stream into an AST.
+ *
+ * Errors are reported to diagnostics, and parsing carries on past them at
+ * the next statement or declaration, so that a single run reports as many
+ * errors as possible.  Statements and declarations with errors are left
+ * out of the AST.
+ */
+AST parse_tokens(TokenStream& tokens, DiagnosticEngine& diagnostics);
+
+
+/**
+ * Same as parse_tokens(), but splits the top-level declarations into
+ * chunks of roughly chunk_tokens tokens and parses them on the given
+ * thread pool (the default one if none is given), each into its own
+ * arena.
+ *
+ * Chunk boundaries are found by a quick scan over the token types that
+ * matches brackets, and the same scan collects the names of top-level
+ * const functions, which every later declaration needs in scope to parse
+ * infix calls.  Both are only guesses for malformed input, so the chunks
+ * are checked in order afterwards and re-parsed sequentially where they
+ * don't line up.  The result is always the same as parse_tokens()'s.
+ *
+ * The returned AST owns the chunks' arenas.
+ */
+AST parse_tokens_parallel(const TokenBuffer& tokens, DiagnosticEngine& diagnostics, ThreadPool& pool, size_t chunk_tokens = 1 << 16);
+AST parse_tokens_parallel(const TokenBuffer& tokens, DiagnosticEngine& diagnostics, size_t chunk_tokens = 1 << 16);
+
+
+/**
+ * Same as parse_tokens(), but only parses what's needed for an outline of
+ * the declarations.  Function bodies are skipped over by matching
+ * parentheses, and only parsed the first time they're asked for with
+ * FuncLiteralNode::ensure_body_parsed().  Errors in a body are reported
+ * to diagnostics when it's parsed.
+ *
+ * Both tokens and diagnostics must outlive the returned AST.
+ */
+AST parse_tokens_outline(const TokenBuffer& tokens, DiagnosticEngine& diagnostics);
+
+
+/**
+ * Thrown by Parser::parsing_error() once the error has been reported, to
+ * unwind to the nearest statement or declaration boundary.  Never escapes
+ * the parser.
+ */
+struct ParseError {};
 
-#define PARSE_ERROR_MESSAGE_MAX_LENGTH 4096
 
-class ParseError: std::exception
+class Parser
 {
-public:
-	Token token;
-	char error_message[PARSE_ERROR_MESSAGE_MAX_LENGTH];
+	TokenStream& token_iter;
+	DiagnosticEngine& diagnostics;
+	bool reported_unclosed_scope = false; // Errors at the end of input are just fallout from this
 
-	ParseError(Token token): token {token}
-	{
-		error_message[0] = '\0';
-	}
+	ScopeStack<uint32_t> fn_scope;  // Tracks what const functions are in scope, see declare_const_functions()
+	uint32_t earlier_fns_in_scope = 0; // How many of the functions given to declare_const_functions() are in scope
+	std::vector<uint32_t> top_level_fns; // Every const function declared at the top level, in order
 
-	ParseError(Token token, const std::string& message): token {token}
-	{
-		init_message(message.data(), message.size());
-	}
+	std::vector<int> op_prec; // Binary operator precidence, indexed by symbol ID
 
-	ParseError(Token token, const char* message): token {token}
-	{
-		const auto len = strlen(message);
-		init_message(message, len);
-	}
+	ScratchStack scratch; // For building the AST's lists
 
-// HACK: MSVC 2012/2013 doesn't support `noexcept`
-#ifdef _MSC_VER
-	virtual const char* what() const
-	{
-#else
-	virtual const char* what() const noexcept
-	{
-#endif
-		return error_message;
-	}
+	DeferredBodyParser* deferred_bodies = nullptr; // If set, function bodies are skipped and left to this
 
+	AST ast;
 
 
+public:
+	Parser(TokenStream& tokens, DiagnosticEngine& diagnostics);
+	AST parse();
 
-private:
-	void init_message(const char* message, size_t message_length)
+	/**
+	 * Parses top-level declarations from the current token, stopping at
+	 * the end of input or at the first declaration that starts at or past
+	 * token index end.  The returned AST's root holds the declarations,
+	 * but it has no line index.
+	 */
+	AST parse_range(size_t end);
+
+	/**
+	 * Puts const functions declared before the tokens being parsed in
+	 * scope, given in declaration order.  Each is kept in the outermost
+	 * scope with its place in that order (counting from 1), so that
+	 * limit_const_functions() can later leave all but the first few out
+	 * of scope without pushing or popping anything.  Functions declared
+	 * while parsing are kept with 0, and always count.
+	 */
+	void declare_const_functions(const uint32_t* begin, const uint32_t* end)
 	{
-		const size_t len = message_length <= PARSE_ERROR_MESSAGE_MAX_LENGTH ? message_length : PARSE_ERROR_MESSAGE_MAX_LENGTH;
-
-		for (int i = 0; i < len; ++i) {
-			error_message[i] = message[i];
-		}
-
-		error_message[PARSE_ERROR_MESSAGE_MAX_LENGTH-1] = '\0';
+		for (const uint32_t* symbol = begin; symbol != end; ++symbol)
+			fn_scope.push_symbol(*symbol, static_cast<uint32_t>(symbol - begin) + 1);
+		earlier_fns_in_scope = static_cast<uint32_t>(end - begin);
 	}
-};
-
-
-class Parser
-{
-	std::string file_path;
 
-	std::vector<Token>::const_iterator begin;
-	std::vector<Token>::const_iterator end;
-	std::vector<Token>::const_iterator token_iter;
-
-	ScopeStack<bool> fn_scope;  // Tracks what const functions are in scope
-
-	std::unordered_map<StringSlice, int> op_prec; // Binary operator precidence map
-	std::string binary_op_list; // Storage for operator strings, referenced by op_prec
-
-	AST ast;
+	// Leaves only the first count functions given to
+	// declare_const_functions() in scope
+	void limit_const_functions(uint32_t count)
+	{
+		earlier_fns_in_scope = count;
+	}
 
+	// Skips function bodies at the top level from now on, leaving them to
+	// bodies to parse later
+	void defer_function_bodies(DeferredBodyParser* bodies)
+	{
+		deferred_bodies = bodies;
+	}
 
-public:
-	Parser(std::string file_path, const std::vector<Token>& tokens);
-	AST parse();
+	/**
+	 * Parses a function body that was skipped into store, with the same
+	 * top-level const functions in scope as where it was skipped.  The
+	 * token stream must be read from a TokenBuffer, and the functions
+	 * given to declare_const_functions() must be all of the top-level
+	 * ones.  One parser can parse any number of bodies, in any order.
+	 */
+	ScopeNode* parse_body(const FuncLiteralNode& fn, MemoryArena<>& store);
+
+	// Const functions declared at the top level while parsing, in order,
+	// including ones whose declarations had errors
+	const std::vector<uint32_t>& declared_const_functions() const
+	{
+		return top_level_fns;
+	}
 
 
 private:
@@ -135,7 +189,7 @@ private:
 	// parser_calls.cpp
 	FuncCallNode* parse_standard_func_call();
 	FuncCallNode* parse_unary_func_call();
-	ExprNode* parse_binary_func_call(ExprNode* lhs, int lhs_prec);
+	ExprNode* parse_binary_func_call(ExprNode* lhs, int min_prec);
 
 	// parser_literals.cpp
 	LiteralNode* parse_literal();
@@ -143,6 +197,9 @@ private:
 	struct Type* parse_type();
 	struct Type* parse_struct();
 
+	// parser_outline.cpp
+	void skip_function_body(FuncLiteralNode* node);
+
 
 
 
@@ -153,22 +210,19 @@ private:
 
 	void skip_docstrings()
 	{
-		while (token_iter->type == DOC_STRING)
-			++token_iter;
+		token_iter.skip(DOC_STRING);
 	}
 
 
 	void skip_newlines()
 	{
-		while (token_iter->type == NEWLINE)
-			++token_iter;
+		token_iter.skip(NEWLINE);
 	}
 
 
 	void skip_docstrings_and_newlines()
 	{
-		while (token_iter->type == DOC_STRING || token_iter->type == NEWLINE)
-			++token_iter;
+		token_iter.skip(DOC_STRING, NEWLINE);
 	}
 
 
@@ -178,7 +232,7 @@ private:
 		if (t.type == OPERATOR) {
 			return true;
 		}
-		else if (t.type == IDENTIFIER && fn_scope.is_symbol_in_scope(t.text)) {
+		else if (t.type == IDENTIFIER && fn_scope.is_symbol_in_scope(t.symbol) && fn_scope[t.symbol] <= earlier_fns_in_scope) {
 			return true;
 		}
 		else {
@@ -201,17 +255,27 @@ private:
 	}
 
 
+	// Puts a const function in scope, so that it can be called infix
+	void declare_const_function(uint32_t symbol)
+	{
+		if (fn_scope.depth() == 1)
+			top_level_fns.push_back(symbol);
+		fn_scope.push_symbol(symbol, 0);
+	}
+
+
 	void add_op_prec(const char* op, int prec)
 	{
-		auto itr = binary_op_list.cend();
-		binary_op_list.append(op);
-		op_prec.emplace(StringSlice(itr, binary_op_list.cend()), prec);
+		const uint32_t symbol = global_symbols().intern(op);
+		if (symbol >= op_prec.size())
+			op_prec.resize(symbol + 1, 0);
+		op_prec[symbol] = prec;
 	}
 
 
-	int get_op_prec(StringSlice symbol)
+	int get_op_prec(uint32_t symbol)
 	{
-		if (op_prec.count(symbol) > 0)
+		if (symbol < op_prec.size())
 			return op_prec[symbol];
 		else
 			return 0;
@@ -223,13 +287,28 @@ private:
 	// Error reporting
 	//////////////////////////////////////////////
 
-	// Prints an error and then throws it
-	void parsing_error(Token t, std::string msg = "")
+	// Reports an error, made of the given message pieces (see
+	// DiagnosticEngine::error()), and then throws a ParseError
+	template <typename... PIECES>
+	void parsing_error(Token t, const PIECES& ... message)
+	{
+		if (t.type != LEX_EOF || !reported_unclosed_scope)
+			diagnostics.error(PARSE_ERROR, t.text, message...);
+		throw ParseError();
+	}
+
+
+	// Skips the rest of a statement or declaration after an error: up to
+	// the next newline that isn't nested in brackets, or if in_scope, to
+	// an unmatched ')' that closes the enclosing scope.
+	void synchronize(bool in_scope);
+
+	// Pops any scopes left open by a statement or declaration that was cut
+	// short by an error.
+	void restore_scope_depth(size_t depth)
 	{
-		std::ostringstream fmt;
-		fmt << "\x1b[31;1mParse error:\033[0m \033[1m" << file_path << ":" << t.line + 1 << ":" << t.column << ":\033[0m\n    " << msg;
-		std::cout << fmt.str() << "\n\n";
-		throw ParseError {t, fmt.str()};
+		while (fn_scope.depth() > depth)
+			fn_scope.pop_scope();
 	}
 };
 
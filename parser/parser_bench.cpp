@@ -0,0 +1,175 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <string>
+
+#include "diagnostics.hpp"
+#include "parser.hpp"
+#include "thread_pool.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+BENCHMARK("parser: parse_tokens() throughput")
+{
+	const std::string input = generate_corpus(8 * 1024 * 1024);
+
+	bench_report_throughput("parse_tokens()", input.size(), bench_best_time([&]() {
+		DiagnosticEngine diagnostics;
+		TokenStream tokens(input);
+		parse_tokens(tokens, diagnostics);
+	}));
+}
+
+
+// Functions made of long expressions mixing operators of different
+// precedence, where the binary operator parser backtracks the most.
+static std::string generate_operator_heavy_input(size_t function_count, size_t terms_per_expression)
+{
+	const char* ops[] = {"+", "*", "-", "<<", "/", "<", "&", "=="};
+	const size_t op_count = sizeof(ops) / sizeof(ops[0]);
+
+	std::string s;
+	for (size_t f = 0; f < function_count; ++f) {
+		s += "fn operator_heavy_" + std::to_string(f) + "[a: i32, b: i32] -> i32 (\n";
+		s += "\tval x: i32 = a";
+		for (size_t t = 1; t < terms_per_expression; ++t) {
+			s += " ";
+			s += ops[(f + t * 3) % op_count];
+			s += t % 2 ? " b" : " 7";
+		}
+		s += "\n\treturn x\n)\n\n";
+	}
+	return s;
+}
+
+
+BENCHMARK("parser: arena use on operator-heavy expressions")
+{
+	const std::string input = generate_operator_heavy_input(2000, 64);
+
+	size_t bytes_used = 0;
+	const double t = bench_best_time([&]() {
+		DiagnosticEngine diagnostics;
+		TokenStream tokens(input);
+		AST ast = parse_tokens(tokens, diagnostics);
+		bytes_used = ast.store.bytes_used();
+	});
+
+	std::printf("    %lu bytes of input, %lu bytes of AST\n", (unsigned long)input.size(), (unsigned long)bytes_used);
+	bench_report_throughput("parse_tokens()", input.size(), t);
+}
+
+
+BENCHMARK("parser: long expression scaling")
+{
+	// One expression per input, mixing precedence levels so that operators
+	// keep binding both tighter and looser than the one before
+	const char* ops[] = {"*", "+", "<<", "-", "/", "<", "&", "=="};
+	const size_t op_count = sizeof(ops) / sizeof(ops[0]);
+	const size_t term_counts[] = {1000, 2500, 5000, 10000};
+
+	for (auto terms: term_counts) {
+		std::string input = "val x: i32 = a";
+		for (size_t t = 1; t < terms; ++t) {
+			input += " ";
+			input += ops[(t * 5) % op_count];
+			input += t % 2 ? " b" : " 7";
+		}
+		input += "\n";
+
+		const double t = bench_best_time([&]() {
+			DiagnosticEngine diagnostics;
+			TokenStream tokens(input);
+			parse_tokens(tokens, diagnostics);
+		}, 0.2);
+
+		std::printf("    %5lu terms: %8.3f ms, %6.1f ns per term\n", (unsigned long)terms, t * 1000.0, t * 1.0e9 / terms);
+	}
+}
+
+
+// Generated files are mostly lots of small top-level functions, which is
+// what the parallel parser splits up.
+BENCHMARK("parser: parse_tokens_parallel() vs parse_tokens()")
+{
+	const std::string input = generate_corpus(8 * 1024 * 1024);
+	const TokenBuffer buffer(input);
+	std::printf("    %lu threads\n", (unsigned long)default_thread_pool().size());
+
+	bench_report_throughput("parse_tokens()", input.size(), bench_best_time([&]() {
+		DiagnosticEngine diagnostics;
+		TokenStream tokens(buffer);
+		parse_tokens(tokens, diagnostics);
+	}));
+
+	bench_report_throughput("parse_tokens_parallel()", input.size(), bench_best_time([&]() {
+		DiagnosticEngine diagnostics;
+		parse_tokens_parallel(buffer, diagnostics);
+	}));
+}
+
+// Outlining only looks at the signatures, so it should take time in
+// proportion to the number of declarations rather than the size of the
+// code.
+BENCHMARK("parser: parse_tokens_outline() vs parse_tokens()")
+{
+	const size_t statement_counts[] = {2, 20, 200};
+
+	for (auto statements: statement_counts) {
+		std::string input;
+		for (size_t f = 0; f < 2000; ++f) {
+			input += "fn function_" + std::to_string(f) + "[a: i32, b: i32] -> i32 (\n";
+			for (size_t s = 0; s < statements; ++s)
+				input += "\tval x" + std::to_string(s) + ": i32 = a * (b + " + std::to_string(s) + ") - a\n";
+			input += "\treturn a\n)\n";
+		}
+		const TokenBuffer buffer(input);
+
+		const double full = bench_best_time([&]() {
+			DiagnosticEngine diagnostics;
+			TokenStream tokens(buffer);
+			parse_tokens(tokens, diagnostics);
+		}, 0.2);
+		const double outline = bench_best_time([&]() {
+			DiagnosticEngine diagnostics;
+			parse_tokens_outline(buffer, diagnostics);
+		}, 0.2);
+
+		std::printf("    %3lu statements per function, %9lu bytes: full %8.3f ms, outline %7.3f ms\n", (unsigned long)statements, (unsigned long)input.size(), full * 1000.0, outline * 1000.0);
+	}
+}
+
+// Parsing every deferred body afterwards, as any pass over the whole AST
+// does, should cost about the same as a full parse.
+BENCHMARK("parser: parse_tokens_outline() with every body forced")
+{
+	const size_t function_counts[] = {5000, 10000, 20000, 40000};
+
+	for (auto functions: function_counts) {
+		std::string input;
+		for (size_t f = 0; f < functions; ++f) {
+			const std::string n = std::to_string(f);
+			input += "fn function_" + n + "[a: i32, b: i32] -> i32 (\n";
+			input += "\tval x: i32 = a * (b + " + n + ") - a\n";
+			input += "\treturn x\n)\n";
+		}
+		const TokenBuffer buffer(input);
+
+		const double full = bench_best_time([&]() {
+			DiagnosticEngine diagnostics;
+			TokenStream tokens(buffer);
+			parse_tokens(tokens, diagnostics);
+		}, 0.2);
+		const double forced = bench_best_time([&]() {
+			DiagnosticEngine diagnostics;
+			AST ast = parse_tokens_outline(buffer, diagnostics);
+			for (auto decl: ast.root->declarations) {
+				if (auto fn = node_cast<FuncLiteralNode>(decl->initializer))
+					fn->ensure_body_parsed();
+			}
+		}, 0.2);
+
+		std::printf("    %6lu functions: full %8.3f ms, outline and all bodies %8.3f ms\n", (unsigned long)functions, full * 1000.0, forced * 1000.0);
+	}
+}
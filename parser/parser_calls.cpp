@@ -7,26 +7,23 @@ FuncCallNode* Parser::parse_standard_func_call()
 	auto node = ast.store.alloc<FuncCallNode>();
 	node->code = *token_iter;
 
-	std::vector<ExprNode*> parameters;
+	ScratchList<ExprNode*> parameters(scratch);
 
 	// Get function name
 	if (token_iter->type == IDENTIFIER || token_iter->type == OPERATOR) {
 		node->name = token_iter->text;
+		node->symbol = token_iter->symbol;
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid name for standard function call: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid name for standard function call: '", token_iter->text, "'.");
 	}
 
 	// [
 	++token_iter;
 	if (token_iter->type != LSQUARE) {
 		// Error
-		std::ostringstream msg;
-		msg << "Function call without '[]'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Function call without '[]'.");
 	}
 	++token_iter;
 
@@ -59,9 +56,9 @@ FuncCallNode* Parser::parse_standard_func_call()
 		++token_iter;
 	}
 
-	node->parameters = ast.store.alloc_from_iters(parameters.begin(), parameters.end());
+	node->parameters = parameters.commit(ast.store);
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
 
@@ -75,12 +72,11 @@ FuncCallNode* Parser::parse_unary_func_call()
 	// Get function name
 	if (token_iter->type == IDENTIFIER || token_iter->type == OPERATOR) {
 		node->name = token_iter->text;
+		node->symbol = token_iter->symbol;
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid name for unary function call: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid name for unary function call: '", token_iter->text, "'.");
 	}
 	++token_iter;
 
@@ -88,77 +84,56 @@ FuncCallNode* Parser::parse_unary_func_call()
 	node->parameters = ast.store.alloc_array<ExprNode*>(1);
 	node->parameters[0] = parse_primary_expression();
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
 
 
 // Binary infix function call syntax
-ExprNode* Parser::parse_binary_func_call(ExprNode* lhs, int lhs_prec)
+// Precedence climbing: lhs has already been parsed, and token_iter is on
+// the operator after it.  Consumes operators of at least min_prec,
+// grouping equal precedences to the left, and returns the resulting
+// expression.  Every token is read once, so this is linear in the length
+// of the expression.
+ExprNode* Parser::parse_binary_func_call(ExprNode* lhs, int min_prec)
 {
-	// TODO: fill in node->code properly
-	ExprNode* rhs;
-
-	// Op info
-	StringSlice name = token_iter->text;
-	const int my_prec = get_op_prec(token_iter->text);
-
-	auto pre_rhs = token_iter;
-
-	// Get rhs argument
-	++token_iter;
-	rhs = parse_primary_expression();
-
-	// Handle precedence
-	bool parse_more = false;
-	while (true) {
-		if (token_is_terminator(*token_iter)) {
-			parse_more = false;
+	while (!token_is_terminator(*token_iter)) {
+		// Op info
+		const Token op = *token_iter;
+		const int my_prec = get_op_prec(op.symbol);
+		if (my_prec < min_prec)
 			break;
+
+		if (!token_is_const_function(op)) {
+			// Error
+			parsing_error(op, "Invalid name for binary function call or operator: '", op.text, "'.");
 		}
-		else if (lhs_prec >= my_prec) {
-			token_iter = pre_rhs;
-			return lhs;
+
+		// Get rhs argument, along with any operators that bind more
+		// tightly than this one
+		++token_iter;
+		ExprNode* rhs = parse_primary_expression();
+		while (!token_is_terminator(*token_iter) && get_op_prec(token_iter->symbol) > my_prec)
+			rhs = parse_binary_func_call(rhs, my_prec + 1);
+
+		// Create node
+		// TODO: fill in node->code properly
+		if (op.text == "=") {
+			auto node = ast.store.alloc<AssignmentNode>();
+			node->lhs = lhs;
+			node->rhs = rhs;
+			lhs = node;
 		}
 		else {
-			if (get_op_prec(token_iter->text) > my_prec) {
-				rhs = parse_binary_func_call(rhs, my_prec);
-			}
-			else {
-				parse_more = true;
-				break;
-			}
+			auto node = ast.store.alloc<FuncCallNode>();
+			node->name = op.text;
+			node->symbol = op.symbol;
+			node->parameters = ast.store.alloc_array<ExprNode*>(2);
+			node->parameters[0] = lhs;
+			node->parameters[1] = rhs;
+			lhs = node;
 		}
 	}
 
-	// Create node
-	ExprNode* node;
-	if (pre_rhs->text == "=") {
-		auto temp_node = ast.store.alloc<AssignmentNode>();
-		temp_node->lhs = lhs;
-		temp_node->rhs = rhs;
-		node = temp_node;
-	}
-	else if (token_is_const_function(*pre_rhs)) {
-		auto temp_node = ast.store.alloc<FuncCallNode>();
-		temp_node->name = name;
-		temp_node->parameters = ast.store.alloc_array<ExprNode*>(2);
-		temp_node->parameters[0] = lhs;
-		temp_node->parameters[1] = rhs;
-		node = temp_node;
-	}
-	else {
-		// Error
-		std::ostringstream msg;
-		msg << "Invalid name for binary function call or operator: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
-	}
-
-	// Return appropriate case
-	if (parse_more) {
-		return parse_binary_func_call(node, lhs_prec);
-	}
-	else {
-		return node;
-	}
+	return lhs;
 }
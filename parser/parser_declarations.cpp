@@ -23,9 +23,7 @@ DeclNode* Parser::parse_declaration()
 
 		default: {
 			// TODO
-			std::ostringstream msg;
-			msg << "TODO: not all declarations are implemented yet. ('" << token_iter->text << "')";
-			parsing_error(*token_iter, msg.str());;
+			parsing_error(*token_iter, "TODO: not all declarations are implemented yet. ('", token_iter->text, "')");
 			throw 0; // Silence warnings about not returning, parsing_error throws anyway
 		}
 	}
@@ -46,12 +44,11 @@ ConstantDeclNode* Parser::parse_constant_decl()
 	// Get name
 	if (token_iter->type == IDENTIFIER) {
 		node->name = token_iter->text;
+		node->symbol = token_iter->symbol;
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid constant name: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid constant name: '", token_iter->text, "'.");
 	}
 
 	++token_iter;
@@ -70,15 +67,13 @@ ConstantDeclNode* Parser::parse_constant_decl()
 	// Initializer is required for constants
 	if (token_iter->type != OPERATOR || token_iter->text != "=") {
 		// Error
-		std::ostringstream msg;
-		msg << "Constant '" << node->name << "' has no initializer.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Constant '", node->name, "' has no initializer.");
 	}
 
 	++token_iter;
 	skip_newlines();
 	if (token_iter->type == K_FN) {
-		fn_scope.push_symbol(node->name, node);
+		declare_const_function(node->symbol);
 	}
 
 	// Get initializer
@@ -86,26 +81,22 @@ ConstantDeclNode* Parser::parse_constant_decl()
 
 	// If it's a function literal, also set the type
 	// TODO: this is copy & paste
-	if (dynamic_cast<FuncLiteralNode*>(node->initializer)) {
-		auto init = dynamic_cast<FuncLiteralNode*>(node->initializer);
+	if (auto init = node_cast<FuncLiteralNode>(node->initializer)) {
 		auto init_t = ast.store.alloc<Function_T>();
-		std::vector<Type*> ts;
-		for (auto& p: init->parameters) {
-			ts.push_back(p->type);
+		init_t->parameter_ts = ast.store.alloc_array<Type*>(init->parameters.size());
+		for (size_t i = 0; i < init->parameters.size(); ++i) {
+			init_t->parameter_ts[i] = init->parameters[i]->type;
 		}
-		init_t->parameter_ts = ast.store.alloc_from_iters(ts.begin(), ts.end());
 		init_t->return_t = init->return_type;
 		node->type = init_t;
 	}
 
 	if (!token_is_terminator(*token_iter)) {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid continuation of initializer. ('" << token_iter->text << "')";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid continuation of initializer. ('", token_iter->text, "')");
 	}
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
 
@@ -126,12 +117,11 @@ VariableDeclNode* Parser::parse_variable_decl()
 	skip_newlines();
 	if (token_iter->type == IDENTIFIER) {
 		node->name = token_iter->text;
+		node->symbol = token_iter->symbol;
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid variable name: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid variable name: '", token_iter->text, "'.");
 	}
 
 	++token_iter;
@@ -154,14 +144,12 @@ VariableDeclNode* Parser::parse_variable_decl()
 
 		// If it's a function literal, also set the type
 		// TODO: this is copy & paste
-		if (dynamic_cast<FuncLiteralNode*>(node->initializer)) {
-			auto init = dynamic_cast<FuncLiteralNode*>(node->initializer);
+		if (auto init = node_cast<FuncLiteralNode>(node->initializer)) {
 			auto init_t = ast.store.alloc<Function_T>();
-			std::vector<Type*> ts;
-			for (auto& p: init->parameters) {
-				ts.push_back(p->type);
+			init_t->parameter_ts = ast.store.alloc_array<Type*>(init->parameters.size());
+			for (size_t i = 0; i < init->parameters.size(); ++i) {
+				init_t->parameter_ts[i] = init->parameters[i]->type;
 			}
-			init_t->parameter_ts = ast.store.alloc_from_iters(ts.begin(), ts.end());
 			init_t->return_t = init->return_type;
 			node->type = init_t;
 		}
@@ -174,12 +162,10 @@ VariableDeclNode* Parser::parse_variable_decl()
 
 	if (!token_is_terminator(*token_iter)) {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid continuation of expression: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid continuation of expression: '", token_iter->text, "'.");
 	}
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
 
@@ -197,16 +183,15 @@ ConstantDeclNode* Parser::parse_func_definition()
 	skip_newlines();
 	if (token_iter->type == IDENTIFIER || token_iter->type == OPERATOR) {
 		node->name = token_iter->text;
+		node->symbol = token_iter->symbol;
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid function name: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid function name: '", token_iter->text, "'.");
 	}
 
 	// Push name onto scope stack
-	fn_scope.push_symbol(node->name, node);
+	declare_const_function(node->symbol);
 
 	// Function definition
 	++token_iter;
@@ -215,17 +200,16 @@ ConstantDeclNode* Parser::parse_func_definition()
 
 	// Set the type
 	// TODO: this is copy & paste
-	auto init = dynamic_cast<FuncLiteralNode*>(node->initializer);
+	auto init = static_cast<FuncLiteralNode*>(node->initializer);
 	auto init_t = ast.store.alloc<Function_T>();
-	std::vector<Type*> ts;
-	for (auto& p: init->parameters) {
-		ts.push_back(p->type);
+	init_t->parameter_ts = ast.store.alloc_array<Type*>(init->parameters.size());
+	for (size_t i = 0; i < init->parameters.size(); ++i) {
+		init_t->parameter_ts[i] = init->parameters[i]->type;
 	}
-	init_t->parameter_ts = ast.store.alloc_from_iters(ts.begin(), ts.end());
 	init_t->return_t = init->return_type;
 	node->type = init_t;
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
 
@@ -242,12 +226,11 @@ NominalTypeDeclNode* Parser::parse_nominal_type_decl()
 	// Type name
 	if (token_iter->type == IDENTIFIER) {
 		node->name = token_iter->text;
+		node->symbol = token_iter->symbol;
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Invalid type name: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Invalid type name: '", token_iter->text, "'.");
 	}
 
 	// Iterate past ":"
@@ -255,17 +238,16 @@ NominalTypeDeclNode* Parser::parse_nominal_type_decl()
 	skip_newlines();
 	if (token_iter->type != COLON) {
 		// Error
-		std::ostringstream msg;
-		msg << "Unexpected token: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Unexpected token: '", token_iter->text, "'.");
 	}
 
 	++token_iter;
 	skip_newlines();
 	node->type = parse_type();
 	node->type->name = node->name;
+	node->type->symbol = node->symbol;
 
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
\ No newline at end of file
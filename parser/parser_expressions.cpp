@@ -17,7 +17,7 @@ ExprNode* Parser::parse_expression()
 	// Now that we have an lhs, let's see if there are any binary ops
 	// following it.
 	if (token_is_terminator(*token_iter)) {
-		code_slice.text.set_end((token_iter - 1)->text.end());
+		code_slice.text.set_end(token_iter.prev().text.end());
 		lhs->code = code_slice;
 		return lhs;
 	}
@@ -27,12 +27,10 @@ ExprNode* Parser::parse_expression()
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Expected a binary operator, but instead found '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Expected a binary operator, but instead found '", token_iter->text, "'.");
 	}
 
-	code_slice.text.set_end((token_iter - 1)->text.end());
+	code_slice.text.set_end(token_iter.prev().text.end());
 	lhs->code = code_slice;
 	return lhs;
 }
@@ -89,9 +87,7 @@ ExprNode* Parser::parse_primary_expression()
 				}
 				else {
 					// TODO
-					std::ostringstream msg;
-					msg << "TODO: can't parse const functions as values yet. ('" << token_iter->text << "')";
-					parsing_error(*token_iter, msg.str());
+					parsing_error(*token_iter, "TODO: can't parse const functions as values yet. ('", token_iter->text, "')");
 				}
 			}
 			// Token is some other identifier
@@ -108,8 +104,6 @@ ExprNode* Parser::parse_primary_expression()
 	}
 
 	// Error
-	std::ostringstream msg;
-	msg << "ICE parse_primary_expression(). ('" << token_iter->text << "')";
-	parsing_error(*token_iter, msg.str());
+	parsing_error(*token_iter, "ICE parse_primary_expression(). ('", token_iter->text, "')");
 	throw 0; // Silence warnings about not returning, parsing_error throws anyway
 }
@@ -10,18 +10,27 @@ LiteralNode* Parser::parse_literal()
 		case INTEGER_LIT: {
 			auto node = ast.store.alloc<IntegerLiteralNode>();
 			node->text = token_iter->text;
+			node->value = token_iter->value.integer;
+			node->code = *token_iter;
+			++token_iter;
+			return node;
+		}
+		case FLOAT_LIT: {
+			auto node = ast.store.alloc<FloatLiteralNode>();
+			node->text = token_iter->text;
+			node->value = token_iter->value.real;
 			node->code = *token_iter;
 			++token_iter;
 			return node;
 		}
-		case FLOAT_LIT:
 		case STRING_LIT:
 		case RAW_STRING_LIT: {
-			// TODO
-			std::ostringstream msg;
-			msg << "TODO: some literals are not parsed yet. ('" << token_iter->text << "').";
-			parsing_error(*token_iter, msg.str());
-			break;
+			auto node = ast.store.alloc<StringLiteralNode>();
+			node->text = token_iter->text;
+			node->value = string_literal_value(*token_iter);
+			node->code = *token_iter;
+			++token_iter;
+			return node;
 		}
 
 		case K_FN:
@@ -32,9 +41,7 @@ LiteralNode* Parser::parse_literal()
 	}
 
 	// ERROR
-	std::ostringstream msg;
-	msg << "ICE parse_literal(). ('" << token_iter->text << "').";
-	parsing_error(*token_iter, msg.str());
+	parsing_error(*token_iter, "ICE parse_literal(). ('", token_iter->text, "').");
 	throw 0;
 }
 
@@ -44,7 +51,7 @@ FuncLiteralNode* Parser::parse_function_literal(bool has_fn)
 {
 	auto node = ast.store.alloc<FuncLiteralNode>();
 	node->code = *token_iter;
-	std::vector<VariableDeclNode*> parameters;
+	ScratchList<VariableDeclNode*> parameters(scratch);
 
 	if (has_fn) {
 		if (token_iter->type == K_FN) {
@@ -53,18 +60,14 @@ FuncLiteralNode* Parser::parse_function_literal(bool has_fn)
 		}
 		else {
 			// Error
-			std::ostringstream msg;
-			msg << "Function literal must start with 'fn'.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Function literal must start with 'fn'.");
 		}
 	}
 
 	// Open bracket
 	if (token_iter->type != LSQUARE) {
 		// Error
-		std::ostringstream msg;
-		msg << "Attempted to define a function without a parameter list.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Attempted to define a function without a parameter list.");
 	}
 
 	// Parameters
@@ -73,16 +76,14 @@ FuncLiteralNode* Parser::parse_function_literal(bool has_fn)
 		// Parameter name
 		++token_iter;
 		skip_newlines();
-		StringSlice name;
+		Token name;
 		if (token_iter->type == IDENTIFIER)
-			name = token_iter->text;
+			name = *token_iter;
 		else if (token_iter->type == RSQUARE)
 			break;
 		else {
 			// Error
-			std::ostringstream msg;
-			msg << "Something fishy with the end of this function definition's parameter list.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Something fishy with the end of this function definition's parameter list.");
 		}
 
 		// Colon
@@ -90,15 +91,14 @@ FuncLiteralNode* Parser::parse_function_literal(bool has_fn)
 		skip_newlines();
 		if (token_iter->type != COLON) {
 			// Error
-			std::ostringstream msg;
-			msg << "Function parameter lacks a type.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Function parameter lacks a type.");
 		}
 
 		// Parameter type
 		++token_iter;
 		skip_newlines();
-		auto param_node = ast.store.alloc(VariableDeclNode(name, parse_type(), ast.store.alloc<EmptyExprNode>(), false));
+		auto param_node = ast.store.emplace<VariableDeclNode>(name.text, parse_type(), ast.store.alloc<EmptyExprNode>(), false);
+		param_node->symbol = name.symbol;
 		parameters.push_back(param_node);
 
 		// Either a comma or closing square bracket
@@ -109,13 +109,11 @@ FuncLiteralNode* Parser::parse_function_literal(bool has_fn)
 			break;
 		else {
 			// Error
-			std::ostringstream msg;
-			msg << "Something fishy with the end of this function declaration's parameter list.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Something fishy with the end of this function declaration's parameter list.");
 		}
 	}
 
-	node->parameters = ast.store.alloc_from_iters(parameters.begin(), parameters.end());
+	node->parameters = parameters.commit(ast.store);
 
 	// -> (optional return type)
 	++token_iter;
@@ -135,18 +133,21 @@ FuncLiteralNode* Parser::parse_function_literal(bool has_fn)
 	// Function body
 	skip_newlines();
 	if (token_iter->type == LPAREN) {
-		node->body = parse_scope();
+		// Top-level functions' bodies can be deferred, which leaves
+		// fn_scope inside the parameters scope
+		if (deferred_bodies != nullptr && fn_scope.depth() == 2)
+			skip_function_body(node);
+		else
+			node->body = parse_scope();
 	}
 	else {
 		// Error
-		std::ostringstream msg;
-		msg << "Function definition has no body.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Function definition has no body.");
 	}
 
 	fn_scope.pop_scope(); // End parameters scope
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
 
@@ -222,6 +223,7 @@ Type* Parser::parse_type()
 			// pass over the AST.
 			auto t = ast.store.alloc<Unknown_T>();
 			t->name = token_iter->text;
+			t->symbol = token_iter->symbol;
 			++token_iter;
 			return t;
 		}
@@ -232,9 +234,7 @@ Type* Parser::parse_type()
 	}
 
 	// Error, unknown type
-	std::ostringstream msg;
-	msg << "Invalid type name: '" << token_iter->text << "'.";
-	parsing_error(*token_iter, msg.str());
+	parsing_error(*token_iter, "Invalid type name: '", token_iter->text, "'.");
 
 	// Bogus return, will never be reached because parsing_error() throws.
 	// It's here just to silence warnings.
@@ -253,20 +253,24 @@ Type* Parser::parse_struct()
 	// Iterate past "{"
 	if (token_iter->type != LCURLY) {
 		// Error
-		std::ostringstream msg;
-		msg << "Unexpected token: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Unexpected token: '", token_iter->text, "'.");
 	}
 
-	std::vector<StringSlice> names;
-	std::vector<Type*> types;
+	// Names and types are gathered together, since only one list can be
+	// built on the scratch stack at a time.
+	struct Field {
+		StringSlice name;
+		Type* type;
+	};
+	ScratchList<Field> fields(scratch);
 
 	while (true) {
 		// Get name
 		++token_iter;
 		skip_newlines();
+		Field field;
 		if (token_iter->type == IDENTIFIER) {
-			names.push_back(token_iter->text);
+			field.name = token_iter->text;
 		}
 		else {
 			break;
@@ -277,15 +281,14 @@ Type* Parser::parse_struct()
 		skip_newlines();
 		if (token_iter->type != COLON) {
 			// Error
-			std::ostringstream msg;
-			msg << "Unexpected token: '" << token_iter->text << "'.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Unexpected token: '", token_iter->text, "'.");
 		}
 
 		// Type
 		++token_iter;
 		skip_newlines();
-		types.push_back(parse_type());
+		field.type = parse_type();
+		fields.push_back(field);
 
 		// Possible comma
 		skip_newlines();
@@ -297,28 +300,28 @@ Type* Parser::parse_struct()
 	// Iterate past "}"
 	if (token_iter->type != RCURLY) {
 		// Error
-		std::ostringstream msg;
-		msg << "Unexpected token: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Unexpected token: '", token_iter->text, "'.");
 	}
 	++token_iter;
 	skip_newlines();
 
 	// Make sure there are no duplicate field names
 	std::unordered_set<StringSlice> name_dup_check_set_thing;
-	for (auto& name : names) {
-		auto b = name_dup_check_set_thing.insert(name);
+	for (size_t i = 0; i < fields.size(); ++i) {
+		auto b = name_dup_check_set_thing.insert(fields[i].name);
 		if (!b.second) {
 			// Error
-			std::ostringstream msg;
-			msg << "Duplicate field name found: '" << name << "'.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Duplicate field name found: '", fields[i].name, "'.");
 		}
 	}
 
 	// Put the names and types in the struct
-	type->field_names = ast.store.alloc_from_iters(names.begin(), names.end());
-	type->field_types = ast.store.alloc_from_iters(types.begin(), types.end());
+	type->field_names = ast.store.alloc_array<StringSlice>(fields.size());
+	type->field_types = ast.store.alloc_array<Type*>(fields.size());
+	for (size_t i = 0; i < fields.size(); ++i) {
+		type->field_names[i] = fields[i].name;
+		type->field_types[i] = fields[i].type;
+	}
 
 	return type;
 }
@@ -0,0 +1,77 @@
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+#include <vector>
+
+
+/**
+ * Parses the bodies skipped by parse_tokens_outline(), on demand.  A
+ * single Parser does all of them, with every top-level const function
+ * declared up front and cut off per body at the ones declared before it.
+ * All of the bodies go into one arena.
+ */
+class OutlineBodyParser: public DeferredBodyParser
+{
+	TokenStream stream;
+	Parser parser;
+	MemoryArena<> store;
+
+public:
+	OutlineBodyParser(const TokenBuffer& tokens, DiagnosticEngine& diagnostics): stream {tokens}, parser {stream, diagnostics}
+	{}
+
+	// Sets the top-level const functions, in declaration order
+	void set_const_functions(const std::vector<uint32_t>& fns)
+	{
+		parser.declare_const_functions(fns.data(), fns.data() + fns.size());
+	}
+
+	virtual ScopeNode* parse_body(const FuncLiteralNode& fn)
+	{
+		return parser.parse_body(fn, store);
+	}
+};
+
+
+AST parse_tokens_outline(const TokenBuffer& tokens, DiagnosticEngine& diagnostics)
+{
+	std::unique_ptr<OutlineBodyParser> bodies(new OutlineBodyParser(tokens, diagnostics));
+
+	TokenStream stream(tokens);
+	Parser parser(stream, diagnostics);
+	parser.defer_function_bodies(bodies.get());
+	AST ast = parser.parse();
+
+	bodies->set_const_functions(parser.declared_const_functions());
+	ast.deferred_bodies = std::move(bodies);
+	return ast;
+}
+
+
+ScopeNode* Parser::parse_body(const FuncLiteralNode& fn, MemoryArena<>& store)
+{
+	token_iter.seek(fn.body_begin);
+	limit_const_functions(fn.fns_in_scope);
+	reported_unclosed_scope = false;
+	ast.store = std::move(store);
+
+	fn_scope.push_scope(); // The parameters scope, as in parse_function_literal()
+	ScopeNode* body = parse_scope();
+	fn_scope.pop_scope();
+
+	store = std::move(ast.store);
+	return body;
+}
+
+
+// Records where the body starts, and skips to the end of it.  Nothing in
+// it is looked at until it's parsed.
+void Parser::skip_function_body(FuncLiteralNode* node)
+{
+	node->deferred = deferred_bodies;
+	node->body_begin = static_cast<uint32_t>(token_iter.position());
+	node->fns_in_scope = static_cast<uint32_t>(top_level_fns.size());
+	token_iter.skip_parens();
+	node->body_end = static_cast<uint32_t>(token_iter.position());
+}
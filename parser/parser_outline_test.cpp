@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include "config.h"
+
+#include <string>
+
+#include "corpus.hpp"
+#include "diagnostics.hpp"
+#include "parser.hpp"
+#include "test_utils.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+// Once every body has been asked for, an outline parse should be the same
+// as a full one.
+static void check_outline_matches(const std::string& input)
+{
+	const TokenBuffer buffer(input);
+
+	DiagnosticEngine expected_diagnostics;
+	TokenStream tokens(buffer);
+	AST expected = parse_tokens(tokens, expected_diagnostics);
+
+	DiagnosticEngine diagnostics;
+	AST ast = parse_tokens_outline(buffer, diagnostics);
+	REQUIRE(ast.root->declarations.size() == expected.root->declarations.size());
+	for (auto decl: ast.root->declarations) {
+		if (auto fn = dynamic_cast<FuncLiteralNode*>(decl->initializer)) {
+			REQUIRE(fn->body == nullptr);
+			REQUIRE(buffer.type(fn->body_begin) == LPAREN);
+			REQUIRE(buffer.type(fn->body_end - 1) == RPAREN);
+			fn->ensure_body_parsed();
+		}
+	}
+
+	REQUIRE(print_to_string(ast) == print_to_string(expected));
+	REQUIRE(diagnostics.error_count() == expected_diagnostics.error_count());
+
+	// The body parser is shared, so the order bodies are asked for in
+	// shouldn't matter
+	DiagnosticEngine reverse_diagnostics;
+	AST reverse = parse_tokens_outline(buffer, reverse_diagnostics);
+	for (size_t i = reverse.root->declarations.size(); i > 0; --i) {
+		if (auto fn = node_cast<FuncLiteralNode>(reverse.root->declarations[i - 1]->initializer))
+			fn->ensure_body_parsed();
+	}
+	REQUIRE(print_to_string(reverse) == print_to_string(expected));
+	REQUIRE(reverse_diagnostics.error_count() == expected_diagnostics.error_count());
+}
+
+
+TEST_CASE("Outline parsing matches full parsing once bodies are parsed", "[parser]")
+{
+	check_outline_matches(read_file(std::string(SOURCE_DIR) + "/doc/examples/test.rune"));
+	check_outline_matches(generate_corpus(20000));
+}
+
+
+TEST_CASE("Outline parsing defers bodies and their errors", "[parser]")
+{
+	const std::string input =
+	    "fn first[a: i32] -> i32 (\n"
+	    "\treturn a add 1\n"
+	    ")\n"
+	    "fn add[a: i32, b: i32] -> i32 (\n"
+	    "\tval x: i32 = a +\n"
+	    "\treturn x\n"
+	    ")\n"
+	    "fn last[a: i32] -> i32 (\n"
+	    "\treturn a add 1\n"
+	    ")\n";
+	const TokenBuffer buffer(input);
+	DiagnosticEngine diagnostics;
+	AST ast = parse_tokens_outline(buffer, diagnostics);
+
+	REQUIRE(!diagnostics.has_errors());
+	REQUIRE(ast.root->declarations.size() == 3);
+
+	// Only "add" is in scope for the last function, just as in a full parse
+	auto first = dynamic_cast<FuncLiteralNode*>(ast.root->declarations[0]->initializer);
+	auto last = dynamic_cast<FuncLiteralNode*>(ast.root->declarations[2]->initializer);
+	REQUIRE(last->ensure_body_parsed()->statements.size() == 1);
+	REQUIRE(!diagnostics.has_errors());
+	first->ensure_body_parsed();
+	REQUIRE(diagnostics.error_count() == 1);
+
+	// Parsed once only
+	auto add = dynamic_cast<FuncLiteralNode*>(ast.root->declarations[1]->initializer);
+	ScopeNode* body = add->ensure_body_parsed();
+	REQUIRE(diagnostics.error_count() == 2);
+	REQUIRE(body->statements.size() == 1);
+	REQUIRE(add->ensure_body_parsed() == body);
+	REQUIRE(diagnostics.error_count() == 2);
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "parser.hpp"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+
+// What the quick scan over the token types found: where the chunks start,
+// and the top-level const functions.
+struct TopLevelScan {
+	std::vector<size_t> chunk_starts; // Token index of each chunk's first declaration
+	std::vector<size_t> fn_positions; // Token index of each const function's declaration
+	std::vector<uint32_t> fn_symbols; // And its name
+};
+
+
+// The results of parsing one chunk.  Parsing stops at the first
+// declaration that starts at or past end, which is the next chunk's begin
+// unless some declaration ran over it.
+struct ParsedChunk {
+	size_t begin = 0;
+	size_t end = 0;
+	size_t fns_before = 0; // Number of const functions declared before begin, according to the scan
+
+	DiagnosticEngine diagnostics;
+	std::unique_ptr<TokenStream> tokens;
+	std::unique_ptr<Parser> parser;
+	AST ast;
+	size_t stopped_at = 0;
+};
+
+
+static bool is_open_bracket(TokenType t)
+{
+	return t == LPAREN || t == LSQUARE || t == LCURLY;
+}
+
+static bool is_close_bracket(TokenType t)
+{
+	return t == RPAREN || t == RSQUARE || t == RCURLY;
+}
+
+
+// Index of the first token at or after i that isn't a newline
+static size_t skip_newlines(const TokenBuffer& tokens, size_t i)
+{
+	return tokens.skip(i, NEWLINE, NEWLINE);
+}
+
+
+// If the declaration at i declares a const function, returns its name,
+// otherwise NO_SYMBOL.  Mirrors where the parser calls
+// declare_const_function(): "fn name", and "const name [: type] = fn".
+static uint32_t const_function_name(const TokenBuffer& tokens, size_t i, uint32_t assign_symbol)
+{
+	const TokenType keyword = tokens.type(i);
+	i = skip_newlines(tokens, i + 1);
+
+	if (keyword == K_FN)
+		return (tokens.type(i) == IDENTIFIER || tokens.type(i) == OPERATOR) ? tokens.symbol(i) : NO_SYMBOL;
+
+	if (keyword != K_CONST || tokens.type(i) != IDENTIFIER)
+		return NO_SYMBOL;
+	const uint32_t name = tokens.symbol(i);
+
+	// Find the "=" after the optional type
+	int depth = 0;
+	for (++i; tokens.type(i) != LEX_EOF; ++i) {
+		const TokenType t = tokens.type(i);
+		if (is_open_bracket(t)) {
+			++depth;
+		}
+		else if (is_close_bracket(t)) {
+			if (depth == 0)
+				return NO_SYMBOL;
+			--depth;
+		}
+		else if (depth == 0 && t == NEWLINE) {
+			return NO_SYMBOL;
+		}
+		else if (depth == 0 && t == OPERATOR) {
+			if (tokens.symbol(i) != assign_symbol)
+				return NO_SYMBOL;
+			i = skip_newlines(tokens, i + 1);
+			return tokens.type(i) == K_FN ? name : NO_SYMBOL;
+		}
+	}
+	return NO_SYMBOL;
+}
+
+
+/**
+ * Finds the top-level declarations by matching brackets, and groups them
+ * into chunks of at least chunk_tokens tokens.  A declaration starts with
+ * a declaration keyword outside of any brackets, at the start of a line
+ * that doesn't continue an expression from the line before.
+ */
+static TopLevelScan scan_top_level(const TokenBuffer& tokens, size_t chunk_tokens)
+{
+	const uint32_t assign_symbol = global_symbols().intern("=");
+
+	TopLevelScan scan;
+	scan.chunk_starts.push_back(0);
+
+	int depth = 0;
+	bool at_line_start = true;
+	for (size_t i = 0; tokens.type(i) != LEX_EOF; ++i) {
+		const TokenType t = tokens.type(i);
+		if (t == NEWLINE || t == DOC_STRING)
+			continue;
+
+		if (is_open_bracket(t)) {
+			++depth;
+		}
+		else if (is_close_bracket(t)) {
+			depth = depth > 0 ? depth - 1 : 0;
+		}
+		else if (depth == 0 && at_line_start && (t == K_CONST || t == K_VAL || t == K_VAR || t == K_FN || t == K_STRUCT || t == K_TYPE)) {
+			if (i >= scan.chunk_starts.back() + chunk_tokens)
+				scan.chunk_starts.push_back(i);
+
+			const uint32_t name = const_function_name(tokens, i, assign_symbol);
+			if (name != NO_SYMBOL) {
+				scan.fn_positions.push_back(i);
+				scan.fn_symbols.push_back(name);
+			}
+		}
+
+		// Operators at the end of a line carry the expression on to the
+		// next one
+		at_line_start = tokens.type(i + 1) == NEWLINE && t != OPERATOR && t != COMMA && t != COLON;
+	}
+
+	return scan;
+}
+
+
+AST parse_tokens_parallel(const TokenBuffer& tokens, DiagnosticEngine& diagnostics, ThreadPool& pool, size_t chunk_tokens)
+{
+	if (chunk_tokens == 0)
+		chunk_tokens = 1;
+
+	const TopLevelScan scan = scan_top_level(tokens, chunk_tokens);
+	if (scan.chunk_starts.size() == 1) {
+		TokenStream stream(tokens);
+		return parse_tokens(stream, diagnostics);
+	}
+
+	// Parsers are created up front on this thread, since their
+	// constructor interns the operator names
+	std::vector<ParsedChunk> chunks(scan.chunk_starts.size());
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		ParsedChunk& chunk = chunks[i];
+		chunk.begin = scan.chunk_starts[i];
+		chunk.end = (i + 1) < chunks.size() ? scan.chunk_starts[i + 1] : static_cast<size_t>(-1);
+		chunk.fns_before = std::lower_bound(scan.fn_positions.begin(), scan.fn_positions.end(), chunk.begin) - scan.fn_positions.begin();
+		chunk.tokens.reset(new TokenStream(tokens, chunk.begin));
+		chunk.parser.reset(new Parser(*chunk.tokens, chunk.diagnostics));
+	}
+
+	pool.run(chunks.size(), [&](size_t i) {
+		ParsedChunk& chunk = chunks[i];
+		chunk.parser->declare_const_functions(scan.fn_symbols.data(), scan.fn_symbols.data() + chunk.fns_before);
+		chunk.ast = chunk.parser->parse_range(chunk.end);
+		chunk.stopped_at = chunk.tokens->position();
+	});
+
+	// Stitch the chunks together in order.  A chunk is only used if
+	// parsing really would have reached it at its start, with the same
+	// const functions in scope that it assumed.
+	AST ast;
+	ast.lines = tokens.lines();
+	ast.root = ast.store.alloc<NamespaceNode>();
+	ast.root->code = tokens.token(0);
+	ast.spliced_stores.reserve(chunks.size());
+
+	std::vector<DeclNode*> declarations;
+	std::vector<uint32_t> declared_fns; // Top-level const functions declared so far
+	size_t position = 0; // Where sequential parsing would have got to
+
+	for (auto& chunk: chunks) {
+		if (position >= chunk.end)
+			continue; // Swallowed whole by a declaration that started earlier
+
+		const bool in_sync = position == chunk.begin && declared_fns.size() == chunk.fns_before && std::equal(declared_fns.begin(), declared_fns.end(), scan.fn_symbols.begin());
+
+		std::unique_ptr<TokenStream> reparse_tokens;
+		std::unique_ptr<Parser> reparser;
+		Parser* parser = chunk.parser.get();
+		if (in_sync) {
+			diagnostics.append(chunk.diagnostics);
+		}
+		else {
+			// Parse it again from where parsing really is
+			reparse_tokens.reset(new TokenStream(tokens, position));
+			reparser.reset(new Parser(*reparse_tokens, diagnostics));
+			reparser->declare_const_functions(declared_fns.data(), declared_fns.data() + declared_fns.size());
+			chunk.ast = reparser->parse_range(chunk.end);
+			chunk.stopped_at = reparse_tokens->position();
+			parser = reparser.get();
+		}
+
+		const Slice<DeclNode*> decls = chunk.ast.root->declarations;
+		declarations.insert(declarations.end(), decls.begin(), decls.end());
+		const std::vector<uint32_t>& fns = parser->declared_const_functions();
+		declared_fns.insert(declared_fns.end(), fns.begin(), fns.end());
+		position = chunk.stopped_at;
+
+		ast.spliced_stores.push_back(std::move(chunk.ast.store));
+	}
+
+	ast.root->code.text.set_end(tokens.text(tokens.size() - 1).end());
+	ast.root->declarations = ast.store.alloc_from_iters(declarations.begin(), declarations.end());
+
+	return ast;
+}
+
+
+AST parse_tokens_parallel(const TokenBuffer& tokens, DiagnosticEngine& diagnostics, size_t chunk_tokens)
+{
+	return parse_tokens_parallel(tokens, diagnostics, default_thread_pool(), chunk_tokens);
+}
@@ -0,0 +1,147 @@
+#include "catch.hpp"
+
+#include "config.h"
+
+#include <sstream>
+#include <string>
+
+#include "corpus.hpp"
+#include "diagnostics.hpp"
+#include "parser.hpp"
+#include "test_utils.hpp"
+#include "thread_pool.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+// Everything about a parse that should come out the same either way: the
+// printed AST, where each declaration's code is, and the diagnostics.
+static std::string describe(AST& ast, const DiagnosticEngine& diagnostics, const std::string& input)
+{
+	std::ostringstream out;
+	out << print_to_string(ast);
+
+	for (auto decl: ast.root->declarations)
+		out << "\ndecl " << (decl->code.text.begin() - input.data()) << "-" << (decl->code.text.end() - input.data());
+	for (const Diagnostic* d = diagnostics.begin(); d != nullptr; d = d->next)
+		out << "\nerror " << d->kind << " " << (d->span.begin() - input.data()) << " " << d->message;
+	return out.str();
+}
+
+
+// Chunk sizes are in tokens, so the smallest makes every top-level
+// declaration a chunk of its own
+static void check_parallel_matches(const std::string& input)
+{
+	const TokenBuffer buffer(input);
+
+	DiagnosticEngine expected_diagnostics;
+	TokenStream tokens(buffer);
+	AST expected_ast = parse_tokens(tokens, expected_diagnostics);
+	const std::string expected = describe(expected_ast, expected_diagnostics, input);
+
+	check_chunk_sizes([&](ThreadPool& pool, size_t chunk_size) {
+		DiagnosticEngine diagnostics;
+		AST ast = parse_tokens_parallel(buffer, diagnostics, pool, chunk_size);
+		REQUIRE(describe(ast, diagnostics, input) == expected);
+	});
+}
+
+
+TEST_CASE("Parallel parsing matches sequential", "[parser]")
+{
+	check_parallel_matches(read_file(std::string(SOURCE_DIR) + "/doc/examples/test.rune"));
+	check_parallel_matches(read_file(std::string(SOURCE_DIR) + "/doc/examples/dyn_array.rune"));
+	check_parallel_matches(generate_corpus(20000));
+}
+
+
+// Declaration keywords at the start of a line inside brackets aren't top
+// level, so chunks mustn't start there even though the scan sees a lot
+// of them.
+TEST_CASE("Parallel parsing of declarations nested in brackets", "[parser]")
+{
+	const std::string input =
+	    "fn outer[a: i32] -> i32 (\n"
+	    "\tfn inner[b: i32] -> i32 (\n"
+	    "\t\tval c: i32 = b\n"
+	    "\t\treturn c\n"
+	    "\t)\n"
+	    "\tval d: i32 = (\n"
+	    "\t\tinner(a)\n"
+	    "\t)\n"
+	    "\treturn d\n"
+	    ")\n"
+	    "type Pair: struct {\n"
+	    "\ta: i32,\n"
+	    "\tb: i32,\n"
+	    "}\n"
+	    "val e: i32 = outer(\n"
+	    "\t1\n"
+	    ")\n"
+	    "const f =\n"
+	    "\tfn [a: i32] -> i32 (\n"
+	    "\t\tval g: i32 = a\n"
+	    "\t\treturn g\n"
+	    "\t)\n";
+	check_parallel_matches(input);
+}
+
+
+// Const functions are callable infix from every declaration after theirs,
+// whichever chunk it lands in.
+TEST_CASE("Parallel parsing with const functions", "[parser]")
+{
+	const std::string input =
+	    "fn early[a: i32] -> i32 (\n"
+	    "\treturn a add 1\n"
+	    ")\n"
+	    "fn add[a: i32, b: i32] -> i32 (\n"
+	    "\treturn a + b\n"
+	    ")\n"
+	    "const mul =\n"
+	    "\tfn [a: i32, b: i32] -> i32 (\n"
+	    "\t\treturn a * b\n"
+	    "\t)\n"
+	    "val x: i32 = 1 add 2 mul 3\n"
+	    "fn late[] -> i32 (\n"
+	    "\treturn 2 mul 3 add 4\n"
+	    ")\n";
+	check_parallel_matches(input);
+}
+
+
+// Whether a name is callable infix depends on where it's declared: not
+// before its own declaration, and not outside the body it's declared in,
+// even if a later chunk could see it in the scan.
+TEST_CASE("Parallel parsing with const function forward references", "[parser]")
+{
+	const std::string inputs[] = {
+		"val x: i32 = 1 add 2\nfn add[a: i32, b: i32] -> i32 (\n\treturn a + b\n)\nval y: i32 = 1 add 2\n",
+		"fn f[] -> i32 (\n\tfn local[a: i32, b: i32] -> i32 (\n\t\treturn a\n\t)\n\treturn 1 local 2\n)\nval x: i32 = 1 local 2\n",
+		"fn f[] -> i32 (\n\treturn 1 g 2\n)\nfn g[a: i32, b: i32] -> i32 (\n\treturn 1 f 2\n)\n",
+		"val g: i32 = 1\nfn g[a: i32, b: i32] -> i32 (\n\treturn a\n)\nval x: i32 = 1 g 2\n",
+	};
+	for (const auto& input: inputs) {
+		INFO(input);
+		check_parallel_matches(input);
+	}
+}
+
+
+// Broken input throws off the chunk boundaries and const function scan,
+// which has to be caught and fixed up.
+TEST_CASE("Parallel parsing of malformed input", "[parser]")
+{
+	const std::string inputs[] = {
+		"fn f[] -> i32 (\n\tval a: i64 = 1 +\n\tval b = 2\n\t]\n\treturn b\n)\n\n) stray\nfn g[] -> i32 (\n\treturn 1\n)\n",
+		"fn f[] -> i32 (\n\treturn 1\n\nfn g[] -> i32 (\n\treturn 1 g 2\n)\nval x = 1 g 2\n",
+		"const f: [ = fn[] -> i32 (\n\treturn 1\n)\nval x = 1 f 2\n",
+		"fn f[] -> i32 (\n\tval a = (1\n",
+		"1 + 2\nconst\nfn\nval x = 1\n))\nfn h[] -> i32 ( return 1 )\nval y = 2 h 3\n",
+	};
+	for (const auto& input: inputs) {
+		INFO(input);
+		check_parallel_matches(input);
+	}
+}
\ No newline at end of file
@@ -5,14 +5,12 @@ ScopeNode* Parser::parse_scope()
 {
 	auto node = ast.store.alloc<ScopeNode>();
 	node->code = *token_iter;
-	std::vector<StatementNode*> statements;
+	ScratchList<StatementNode*> statements(scratch);
 
 	// Open scope
 	if (token_iter->type != LPAREN) {
 		// Error
-		std::ostringstream msg;
-		msg << "Opening scope with wrong character: '" << token_iter->text << "'.";
-		parsing_error(*token_iter, msg.str());
+		parsing_error(*token_iter, "Opening scope with wrong character: '", token_iter->text, "'.");
 	}
 	++token_iter;
 
@@ -27,17 +25,34 @@ ScopeNode* Parser::parse_scope()
 			++token_iter;
 			break;
 		}
+		// Ran out of input.  Not thrown, since there's nothing left to
+		// recover in, and each enclosing scope should report itself.
+		else if (token_iter->type == LEX_EOF) {
+			diagnostics.error(PARSE_ERROR, node->code.text, "Scope is never closed with ')'.");
+			reported_unclosed_scope = true;
+			break;
+		}
 		// Should be an expression
 		else {
-			statements.push_back(parse_statement());
+			const size_t scope_depth = fn_scope.depth();
+			const auto store_mark = ast.store.mark();
+			try {
+				statements.push_back(parse_statement());
+			}
+			catch (const ParseError&) {
+				// Already reported, carry on with the next statement
+				restore_scope_depth(scope_depth);
+				ast.store.rewind(store_mark);
+				synchronize(true);
+			}
 		}
 	}
 
-	node->statements = ast.store.alloc_from_iters(statements.begin(), statements.end());
+	node->statements = statements.commit(ast.store);
 
 	// Pop this scope
 	fn_scope.pop_scope();
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
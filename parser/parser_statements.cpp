@@ -36,9 +36,7 @@ StatementNode* Parser::parse_statement()
 
 		default: {
 			// Error
-			std::ostringstream msg;
-			msg << "Unknown statement '" << token_iter->text << "'.";
-			parsing_error(*token_iter, msg.str());
+			parsing_error(*token_iter, "Unknown statement '", token_iter->text, "'.");
 			throw 0; // Silence warnings about not returning, parsing_error throws anyway
 		}
 	}
@@ -49,9 +47,9 @@ ReturnNode* Parser::parse_return()
 	auto node = ast.store.alloc<ReturnNode>();
 	node->code = *token_iter;
 
-	token_iter++;
+	++token_iter;
 	node->expression = parse_expression();
 
-	node->code.text.set_end((token_iter - 1)->text.end());
+	node->code.text.set_end(token_iter.prev().text.end());
 	return node;
 }
@@ -0,0 +1,176 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include "diagnostics.hpp"
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include "token_stream.hpp"
+
+
+static AST parse_string(const std::string& input, DiagnosticEngine& diagnostics)
+{
+	const TokenBuffer buffer(input, diagnostics);
+	TokenStream tokens(buffer);
+	return parse_tokens(tokens, diagnostics);
+}
+
+
+TEST_CASE("Parser reports nothing for valid input", "[parser]")
+{
+	const std::string input = "fn add[a: i32, b: i32] -> i32 (\n\treturn a + b\n)\n";
+	DiagnosticEngine diagnostics;
+	AST ast = parse_string(input, diagnostics);
+
+	REQUIRE(!diagnostics.has_errors());
+	REQUIRE(ast.root->declarations.size() == 1);
+}
+
+
+// Every error should be reported in a single run, with the statements
+// and declarations around them still parsed.
+TEST_CASE("Parser recovers after errors", "[parser]")
+{
+	const std::string input =
+	    "fn first[] -> i32 (\n"
+	    "\tval a: i64 = 1 +\n"
+	    "\tval b = 2\n"
+	    "\t]\n"
+	    "\treturn b\n"
+	    ")\n"
+	    "\n"
+	    ") stray\n"
+	    "fn second[] -> i32 (\n"
+	    "\treturn 1\n"
+	    ")\n";
+	DiagnosticEngine diagnostics;
+	AST ast = parse_string(input, diagnostics);
+
+	REQUIRE(diagnostics.error_count() == 3);
+	const Diagnostic* d = diagnostics.begin();
+	REQUIRE(d->kind == PARSE_ERROR);
+	REQUIRE(d->span.begin() == input.data() + input.find("\n\tval b"));
+	d = d->next;
+	REQUIRE(d->span == "]");
+	d = d->next;
+	REQUIRE(d->span == ")");
+
+	// Both functions survive, and the first keeps its good statements
+	REQUIRE(ast.root->declarations.size() == 2);
+	REQUIRE(ast.root->declarations[0]->name == "first");
+	REQUIRE(ast.root->declarations[1]->name == "second");
+	auto fn = dynamic_cast<FuncLiteralNode*>(ast.root->declarations[0]->initializer);
+	REQUIRE(fn != nullptr);
+	REQUIRE(fn->body->statements.size() == 2);
+}
+
+
+TEST_CASE("Parser reports unclosed scopes", "[parser]")
+{
+	const std::string input = "fn f[] -> i32 (\n\tval a = (1\n";
+	DiagnosticEngine diagnostics;
+	parse_string(input, diagnostics);
+
+	// One for each unclosed scope
+	REQUIRE(diagnostics.error_count() == 2);
+	REQUIRE(diagnostics.begin()->span == "(");
+	REQUIRE(diagnostics.begin()->span.begin() == input.data() + input.rfind('('));
+}
+
+
+TEST_CASE("Lexer errors are reported alongside parse errors", "[parser]")
+{
+	DiagnosticEngine diagnostics;
+	parse_string("fn f[] -> i32 (\n\treturn \"abc\n", diagnostics);
+	REQUIRE(diagnostics.has_errors());
+	REQUIRE(diagnostics.begin()->kind == LEX_ERROR);
+	REQUIRE(diagnostics.begin()->message == "Unterminated string literal.");
+
+	// Malformed utf8 is reported, not thrown
+	DiagnosticEngine utf8_diagnostics;
+	parse_string("abc \x80 d\xC3", utf8_diagnostics);
+	REQUIRE(utf8_diagnostics.error_count() == 2);
+	REQUIRE(utf8_diagnostics.begin()->kind == LEX_ERROR);
+}
+
+
+TEST_CASE("Out of range literals are reported as lexer errors", "[parser]")
+{
+	const std::string input = "val x: i32 = 99999999999999999999999\nval y: f64 = 1e999\n";
+	DiagnosticEngine diagnostics;
+	AST ast = parse_string(input, diagnostics);
+
+	REQUIRE(diagnostics.error_count() == 2);
+	const Diagnostic* d = diagnostics.begin();
+	REQUIRE(d->kind == LEX_ERROR);
+	REQUIRE(d->message == "Integer literal out of range.");
+	REQUIRE(d->span == "99999999999999999999999");
+	d = d->next;
+	REQUIRE(d->kind == LEX_ERROR);
+	REQUIRE(d->message == "Float literal out of range.");
+	REQUIRE(d->span == "1e999");
+
+	// Both declarations still parse
+	REQUIRE(ast.root->declarations.size() == 2);
+}
+
+
+// Writes out a binary expression with every operation parenthesized
+static std::string expression_shape(ExprNode* e)
+{
+	if (auto call = dynamic_cast<FuncCallNode*>(e)) {
+		if (call->parameters.size() == 2)
+			return "(" + expression_shape(call->parameters[0]) + " " + call->name.to_string() + " " + expression_shape(call->parameters[1]) + ")";
+	}
+	else if (auto assignment = dynamic_cast<AssignmentNode*>(e)) {
+		return "(" + expression_shape(assignment->lhs) + " = " + expression_shape(assignment->rhs) + ")";
+	}
+	return e->code.text.to_string();
+}
+
+static std::string parse_expression_shape(const std::string& expression)
+{
+	const std::string input = "val result: i32 = " + expression + "\n";
+	DiagnosticEngine diagnostics;
+	AST ast = parse_string(input, diagnostics);
+	REQUIRE(!diagnostics.has_errors());
+	return expression_shape(ast.root->declarations[0]->initializer);
+}
+
+
+TEST_CASE("Binary operator precedence and grouping", "[parser]")
+{
+	REQUIRE(parse_expression_shape("a + b") == "(a + b)");
+	REQUIRE(parse_expression_shape("a + b * c") == "(a + (b * c))");
+	REQUIRE(parse_expression_shape("a * b + c") == "((a * b) + c)");
+	REQUIRE(parse_expression_shape("a - b - c") == "((a - b) - c)");
+	REQUIRE(parse_expression_shape("a - b * c - d") == "((a - (b * c)) - d)");
+	REQUIRE(parse_expression_shape("a - b * c - d + e") == "(((a - (b * c)) - d) + e)");
+	REQUIRE(parse_expression_shape("a | b ^ c & d == e < f << g + h * i") == "(a | (b ^ (c & (d == (e < (f << (g + (h * i))))))))");
+	REQUIRE(parse_expression_shape("a * b + c * d < e") == "(((a * b) + (c * d)) < e)");
+	REQUIRE(parse_expression_shape("x = a + b") == "(x = (a + b))");
+	REQUIRE(parse_expression_shape("x = a * (b + c)") == "(x = (a * (b + c)))");
+}
+
+
+// Long chains shouldn't re-parse anything, or recurse per term
+TEST_CASE("Long binary operator chains", "[parser]")
+{
+	std::string expression = "a";
+	for (int i = 0; i < 10000; ++i)
+		expression += (i % 2) == 0 ? " + b" : " - c";
+
+	const std::string input = "val result: i32 = " + expression + "\n";
+	DiagnosticEngine diagnostics;
+	AST ast = parse_string(input, diagnostics);
+	REQUIRE(!diagnostics.has_errors());
+
+	// Left-grouped, so the leftmost leaf is 10000 calls deep
+	size_t depth = 0;
+	ExprNode* e = ast.root->declarations[0]->initializer;
+	while (auto call = dynamic_cast<FuncCallNode*>(e)) {
+		e = call->parameters[0];
+		++depth;
+	}
+	REQUIRE(depth == 10000);
+}
\ No newline at end of file
@@ -1,18 +1,38 @@
 #ifndef SCOPE_STACK_HPP
 #define SCOPE_STACK_HPP
 
-#include <unordered_map>
+#include <cstdint>
 #include <vector>
 
-#include "string_slice.hpp"
-#include "ast.hpp"
-
 
+/**
+ * Maps symbols to T's, with nested scopes.  A symbol declared in an inner
+ * scope shadows the same symbol in the outer scopes until the inner scope
+ * is popped.
+ *
+ * Every declaration is appended to a log, and each log entry links to the
+ * entry it shadows.  Symbols are identified by their IDs in the global
+ * SymbolTable, which are dense, so the innermost entry for each symbol is
+ * found through an array indexed by ID: no hashing anywhere.  The array
+ * only grows to cover the symbols actually declared, and the table
+ * itself is never read.  Popping a
+ * scope walks back over just that scope's entries, restoring the ones
+ * they shadowed, and truncates the log.
+ */
 template <typename T>
 class ScopeStack
 {
-	std::unordered_map<StringSlice, T> symbol_table;
-	std::vector<std::vector<StringSlice>> symbol_stack;
+	static const uint32_t NONE = 0xFFFFFFFF;
+
+	struct Entry {
+		uint32_t symbol;
+		uint32_t shadowed; // Entry for the same symbol in an outer scope, or NONE
+		T value;
+	};
+
+	std::vector<Entry> log; // Every declaration in scope, outermost first
+	std::vector<uint32_t> innermost; // Innermost entry for each symbol ID, or NONE
+	std::vector<uint32_t> scope_starts; // Where each scope's entries start in log
 
 public:
 	ScopeStack()
@@ -23,49 +43,75 @@ public:
 
 	void clear()
 	{
-		symbol_table.clear();
-		symbol_stack.clear();
+		log.clear();
+		innermost.clear();
+		scope_starts.clear();
 		push_scope();
 	}
 
 
 	void push_scope()
 	{
-		symbol_stack.push_back(std::vector<StringSlice>());
+		scope_starts.push_back(static_cast<uint32_t>(log.size()));
 	}
 
 
 	void pop_scope()
 	{
-		for (auto &name: symbol_stack.back()) {
-			symbol_table.erase(name);
+		const uint32_t start = scope_starts.back();
+		for (size_t i = log.size(); i > start; --i) {
+			const Entry& e = log[i - 1];
+			innermost[e.symbol] = e.shadowed;
 		}
-		symbol_stack.pop_back();
+		log.resize(start);
+		scope_starts.pop_back();
+	}
+
+
+	// Number of scopes currently pushed
+	size_t depth() const
+	{
+		return scope_starts.size();
 	}
 
 
-	bool push_symbol(StringSlice name, T node)
+	/**
+	 * Declares symbol in the innermost scope, shadowing any declaration
+	 * of it in outer scopes.  Returns false (and does nothing) if it's
+	 * already declared in the innermost scope.
+	 */
+	bool push_symbol(uint32_t symbol, T node)
 	{
-		if (symbol_table.count(name) == 0) {
-			symbol_table.emplace(std::make_pair(name, node));
-			symbol_stack.back().push_back(name);
-			return true;
+		// Only as large as the highest symbol declared so far needs, so
+		// that a short-lived stack stays small however many symbols the
+		// program has
+		if (symbol >= innermost.size()) {
+			const size_t size = innermost.size() * 2 > symbol ? innermost.size() * 2 : symbol + 1;
+			innermost.resize(size, NONE);
 		}
-		else {
+
+		const uint32_t shadowed = innermost[symbol];
+		if (shadowed != NONE && shadowed >= scope_starts.back())
 			return false;
-		}
+
+		innermost[symbol] = static_cast<uint32_t>(log.size());
+		log.push_back(Entry {symbol, shadowed, node});
+		return true;
 	}
 
 
-	bool is_symbol_in_scope(StringSlice name)
+	bool is_symbol_in_scope(uint32_t symbol) const
 	{
-		return symbol_table.count(name) > 0;
+		return symbol < innermost.size() && innermost[symbol] != NONE;
 	}
 
-	T operator[](StringSlice name)
+	T operator[](uint32_t symbol) const
 	{
-		return symbol_table[name];
+		return is_symbol_in_scope(symbol) ? log[innermost[symbol]].value : T();
 	}
 };
 
+template <typename T>
+const uint32_t ScopeStack<T>::NONE;
+
 #endif // SCOPE_STACK_HPP
\ No newline at end of file
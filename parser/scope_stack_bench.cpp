@@ -0,0 +1,211 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lexer.hpp"
+#include "scope_stack.hpp"
+#include "string_slice.hpp"
+#include "symbol_table.hpp"
+
+
+// The StringSlice hash as it used to be, going through a std::string
+struct AllocatingSliceHash {
+	size_t operator()(const StringSlice& s) const
+	{
+		return std::hash<std::string>()(s.to_string());
+	}
+};
+
+
+// ScopeStack as it was before shadowing: a value and an in-scope flag per
+// symbol ID, plus a list of the symbols declared in each scope.
+template <typename T>
+class FlagScopeStack
+{
+	std::vector<T> symbol_table;
+	std::vector<bool> in_scope;
+	std::vector<std::vector<uint32_t>> symbol_stack;
+
+public:
+	FlagScopeStack()
+	{
+		push_scope();
+	}
+
+	void push_scope()
+	{
+		symbol_stack.push_back(std::vector<uint32_t>());
+	}
+
+	void pop_scope()
+	{
+		for (auto symbol: symbol_stack.back()) {
+			in_scope[symbol] = false;
+			symbol_table[symbol] = T();
+		}
+		symbol_stack.pop_back();
+	}
+
+	bool push_symbol(uint32_t symbol, T node)
+	{
+		if (is_symbol_in_scope(symbol))
+			return false;
+		if (symbol >= symbol_table.size()) {
+			symbol_table.resize(symbol + 1, T());
+			in_scope.resize(symbol + 1, false);
+		}
+		symbol_table[symbol] = node;
+		in_scope[symbol] = true;
+		symbol_stack.back().push_back(symbol);
+		return true;
+	}
+
+	bool is_symbol_in_scope(uint32_t symbol) const
+	{
+		return symbol < in_scope.size() && in_scope[symbol];
+	}
+};
+
+
+// Walks a corpus the way link_references() does: a scope per function,
+// with its parameters and locals declared in it, every identifier looked
+// up, and the scope popped at the end.
+template <typename SCOPES>
+static size_t walk_scopes(const std::vector<Token>& tokens, SCOPES& scopes)
+{
+	size_t found = 0;
+	int depth = 0;
+	for (size_t i = 0; i < tokens.size(); ++i) {
+		const Token& t = tokens[i];
+		if (t.type == LPAREN || t.type == LSQUARE) {
+			scopes.push_scope();
+			++depth;
+		}
+		else if ((t.type == RPAREN || t.type == RSQUARE) && depth > 0) {
+			scopes.pop_scope();
+			--depth;
+		}
+		else if (t.type == IDENTIFIER) {
+			if ((i + 1) < tokens.size() && tokens[i + 1].type == COLON)
+				scopes.push_symbol(t.symbol, true);
+			else
+				found += scopes.is_symbol_in_scope(t.symbol);
+		}
+	}
+	for (; depth > 0; --depth)
+		scopes.pop_scope();
+	return found;
+}
+
+
+BENCHMARK("parser: ScopeStack push and pop")
+{
+	const std::string input = generate_corpus(2 * 1024 * 1024);
+	const auto tokens = lex_string(input);
+
+	size_t found = 0;
+	bench_report_rate("per-symbol flags, no shadowing", tokens.size(), bench_best_time([&]() {
+		FlagScopeStack<bool> scopes;
+		found += walk_scopes(tokens, scopes);
+	}));
+	bench_report_rate("ScopeStack, undo log", tokens.size(), bench_best_time([&]() {
+		ScopeStack<bool> scopes;
+		found += walk_scopes(tokens, scopes);
+	}));
+
+	// Keep the results alive
+	if (found == 0)
+		std::printf("    (no lookups hit)\n");
+}
+
+
+// Name lookups in the ways the parser does them: every identifier in a
+// corpus checked against the declared names (as with fn_scope), and every
+// operator against the precedence table (as with op_prec).  The text-keyed
+// maps are what these used to be, with the old and new hashes.
+BENCHMARK("parser: name lookup throughput")
+{
+	const std::string input = generate_corpus(2 * 1024 * 1024);
+	const auto tokens = lex_string(input);
+
+	std::vector<Token> idents;
+	std::vector<Token> ops;
+	for (const auto& t: tokens) {
+		if (t.type == IDENTIFIER)
+			idents.push_back(t);
+		else if (t.type == OPERATOR)
+			ops.push_back(t);
+	}
+
+	// Declare every other distinct identifier
+	std::vector<Token> distinct;
+	{
+		std::unordered_map<StringSlice, bool> seen;
+		for (const auto& t: idents) {
+			if (seen.emplace(t.text, true).second)
+				distinct.push_back(t);
+		}
+	}
+
+	std::unordered_map<StringSlice, bool, AllocatingSliceHash> scope_old;
+	std::unordered_map<StringSlice, bool> scope_new;
+	ScopeStack<bool> scope_ids;
+	for (size_t i = 0; i < distinct.size(); i += 2) {
+		scope_old.emplace(distinct[i].text, true);
+		scope_new.emplace(distinct[i].text, true);
+		scope_ids.push_symbol(distinct[i].symbol, true);
+	}
+
+	size_t found = 0;
+	bench_report_rate("scope, hashed text (std::string)", idents.size(), bench_best_time([&]() {
+		for (const auto& t: idents)
+			found += scope_old.count(t.text);
+	}));
+	bench_report_rate("scope, hashed text (hash_bytes)", idents.size(), bench_best_time([&]() {
+		for (const auto& t: idents)
+			found += scope_new.count(t.text);
+	}));
+	bench_report_rate("ScopeStack, symbol IDs", idents.size(), bench_best_time([&]() {
+		for (const auto& t: idents)
+			found += scope_ids.is_symbol_in_scope(t.symbol);
+	}));
+
+	// Operator precedence
+	const char* op_names[] = {"*", "/", "//", "+", "-", "<<", ">>", "<", ">", "<=", ">=", "==", "!=", "&", "^", "|", "and", "or", "="};
+	std::unordered_map<StringSlice, int, AllocatingSliceHash> prec_old;
+	std::unordered_map<StringSlice, int> prec_new;
+	std::vector<int> prec_ids;
+	for (auto name: op_names) {
+		prec_old.emplace(name, 1);
+		prec_new.emplace(name, 1);
+		const uint32_t symbol = global_symbols().intern(name);
+		if (symbol >= prec_ids.size())
+			prec_ids.resize(symbol + 1, 0);
+		prec_ids[symbol] = 1;
+	}
+
+	int total = 0;
+	bench_report_rate("op_prec, hashed text (std::string)", ops.size(), bench_best_time([&]() {
+		for (const auto& t: ops) {
+			auto itr = prec_old.find(t.text);
+			total += itr != prec_old.end() ? itr->second : 0;
+		}
+	}));
+	bench_report_rate("op_prec, hashed text (hash_bytes)", ops.size(), bench_best_time([&]() {
+		for (const auto& t: ops) {
+			auto itr = prec_new.find(t.text);
+			total += itr != prec_new.end() ? itr->second : 0;
+		}
+	}));
+	bench_report_rate("op_prec, symbol IDs", ops.size(), bench_best_time([&]() {
+		for (const auto& t: ops)
+			total += t.symbol < prec_ids.size() ? prec_ids[t.symbol] : 0;
+	}));
+
+	// Keep the results alive
+	if (found == 0 || total == 0)
+		std::printf("    (no lookups hit)\n");
+}
@@ -0,0 +1,93 @@
+#include "catch.hpp"
+
+#include "scope_stack.hpp"
+#include "symbol_table.hpp"
+
+
+TEST_CASE("ScopeStack lookups", "[scope_stack]")
+{
+	const uint32_t a = global_symbols().intern("scope_stack_test_a");
+	const uint32_t b = global_symbols().intern("scope_stack_test_b");
+
+	ScopeStack<int> scopes;
+	REQUIRE(!scopes.is_symbol_in_scope(a));
+	REQUIRE(scopes[a] == 0);
+
+	REQUIRE(scopes.push_symbol(a, 1));
+	REQUIRE(scopes.is_symbol_in_scope(a));
+	REQUIRE(!scopes.is_symbol_in_scope(b));
+	REQUIRE(scopes[a] == 1);
+
+	// Symbols beyond anything interned yet are simply not in scope
+	REQUIRE(!scopes.is_symbol_in_scope(0xFFFFFF));
+}
+
+
+TEST_CASE("ScopeStack shadowing", "[scope_stack]")
+{
+	const uint32_t a = global_symbols().intern("scope_stack_test_a");
+	const uint32_t b = global_symbols().intern("scope_stack_test_b");
+
+	ScopeStack<int> scopes;
+	REQUIRE(scopes.push_symbol(a, 1));
+
+	scopes.push_scope();
+	REQUIRE(scopes.push_symbol(a, 2));
+	REQUIRE(scopes.push_symbol(b, 3));
+	REQUIRE(scopes[a] == 2);
+
+	scopes.push_scope();
+	REQUIRE(scopes.push_symbol(a, 4));
+	REQUIRE(scopes[a] == 4);
+	REQUIRE(scopes[b] == 3);
+	REQUIRE(scopes.depth() == 3);
+
+	scopes.pop_scope();
+	REQUIRE(scopes[a] == 2);
+
+	scopes.pop_scope();
+	REQUIRE(scopes[a] == 1);
+	REQUIRE(!scopes.is_symbol_in_scope(b));
+	REQUIRE(scopes.depth() == 1);
+}
+
+
+TEST_CASE("ScopeStack redeclaration in the same scope", "[scope_stack]")
+{
+	const uint32_t a = global_symbols().intern("scope_stack_test_a");
+
+	ScopeStack<int> scopes;
+	scopes.push_scope();
+	REQUIRE(scopes.push_symbol(a, 1));
+	REQUIRE(!scopes.push_symbol(a, 2));
+	REQUIRE(scopes[a] == 1);
+
+	scopes.pop_scope();
+	REQUIRE(!scopes.is_symbol_in_scope(a));
+
+	// Declarable again once its scope is gone
+	scopes.push_scope();
+	REQUIRE(scopes.push_symbol(a, 3));
+	REQUIRE(scopes[a] == 3);
+
+	scopes.clear();
+	REQUIRE(!scopes.is_symbol_in_scope(a));
+	REQUIRE(scopes.depth() == 1);
+}
+
+// Symbol IDs don't have to come from the global table, or be declared in
+// any particular order
+TEST_CASE("ScopeStack sparse symbol IDs", "[scope_stack]")
+{
+	ScopeStack<int> scopes;
+	REQUIRE(scopes.push_symbol(100000, 1));
+	REQUIRE(scopes.push_symbol(3, 2));
+	REQUIRE(scopes.push_symbol(100001, 3));
+
+	REQUIRE(scopes[100000] == 1);
+	REQUIRE(scopes[3] == 2);
+	REQUIRE(scopes[100001] == 3);
+	REQUIRE(!scopes.is_symbol_in_scope(4));
+	REQUIRE(!scopes.is_symbol_in_scope(99999));
+	REQUIRE(!scopes.is_symbol_in_scope(5000000));
+}
@@ -0,0 +1,121 @@
+#ifndef TEST_UTILS_HPP
+#define TEST_UTILS_HPP
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "thread_pool.hpp"
+#include "tokens.hpp"
+
+
+/**
+ * Reads a whole file, e.g. one of the examples in doc/examples.  Returns
+ * an empty string if it can't be read.
+ */
+static inline std::string read_file(const std::string& path)
+{
+	std::ifstream f(path, std::ios::in | std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+
+/**
+ * Calls f() and returns everything it wrote to std::cout, which is where
+ * the AST printing and type error reporting write.
+ */
+template <typename F>
+std::string capture_cout(F f)
+{
+	struct Redirect {
+		std::streambuf* old_buf;
+		~Redirect() { std::cout.rdbuf(old_buf); }
+	};
+
+	std::ostringstream out;
+	Redirect redirect {std::cout.rdbuf(out.rdbuf())};
+	f();
+	return out.str();
+}
+
+
+/**
+ * Returns what x.print() prints, e.g. for comparing ASTs.
+ */
+template <typename T>
+std::string print_to_string(T& x)
+{
+	return capture_cout([&]() { x.print(); });
+}
+
+/**
+ * Whether two tokens are the same, including where their text is.  The
+ * version with sources compares where the text is relative to each
+ * token's own source instead, e.g. for tokens lexed from two copies of
+ * the same input.
+ */
+static inline bool same_token(const Token& a, const Token& b)
+{
+	return a.type == b.type && a.symbol == b.symbol && a.value.integer == b.value.integer && a.text.begin() == b.text.begin() && a.text.end() == b.text.end();
+}
+
+static inline bool same_token(const Token& a, const std::string& a_source, const Token& b, const std::string& b_source)
+{
+	return a.type == b.type && a.symbol == b.symbol && a.value.integer == b.value.integer
+	       && (a.text.begin() - a_source.data()) == (b.text.begin() - b_source.data())
+	       && (a.text.end() - a_source.data()) == (b.text.end() - b_source.data());
+}
+
+
+// Whether two token lists are the same, token by token as same_token()
+static inline bool same_tokens(const std::vector<Token>& a, const std::vector<Token>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (!same_token(a[i], b[i]))
+			return false;
+	}
+
+	return true;
+}
+
+static inline bool same_tokens(const std::vector<Token>& a, const std::string& a_source, const std::vector<Token>& b, const std::string& b_source)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (!same_token(a[i], a_source, b[i], b_source))
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * Calls check(pool, chunk_size) with a range of chunk sizes, for checking
+ * that a parallel function gives the same result as its sequential
+ * version however its input is split.  The sizes go down to 1, so that
+ * nearly every boundary in the input gets to be a chunk boundary.  The
+ * pool has several threads whatever the hardware.
+ */
+template <typename F>
+void check_chunk_sizes(F check)
+{
+	ThreadPool pool(4);
+
+	const size_t chunk_sizes[] = {1, 2, 7, 16, 61, 256, 4096};
+	for (auto chunk_size: chunk_sizes) {
+		INFO("chunk size " << chunk_size);
+		check(pool, chunk_size);
+	}
+}
+
+#endif // TEST_UTILS_HPP
@@ -0,0 +1,169 @@
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#include "line_index.hpp"
+#include "memory_arena.hpp"
+#include "string_slice.hpp"
+
+
+enum DiagnosticKind {
+	LEX_ERROR,
+	PARSE_ERROR,
+};
+
+
+/**
+ * A single reported problem: what kind it is, the span of source text it
+ * refers to, and a message.  Diagnostics form a singly linked list in
+ * the order they were reported.
+ */
+struct Diagnostic {
+	DiagnosticKind kind;
+	StringSlice span;
+	StringSlice message;
+	const Diagnostic* next = nullptr;
+};
+
+
+/**
+ * Collects the diagnostics of a compile run, so that every error can be
+ * reported at the end instead of stopping at the first one.
+ *
+ * Diagnostics and their messages are stored in an arena, so reporting one
+ * costs a couple of bump allocations.  Messages are given as a list of
+ * pieces, which are concatenated:
+ *
+ *     diagnostics.error(PARSE_ERROR, token.text, "Unknown statement '", token.text, "'.");
+ *
+ * Pieces can be string literals, StringSlices, std::strings, or integers.
+ */
+class DiagnosticEngine
+{
+	MemoryArena<> arena;
+	Diagnostic* first = nullptr;
+	Diagnostic* last = nullptr;
+	size_t count = 0;
+	std::string message_buffer; // Scratch space for assembling messages
+
+
+	void append_piece(const char* piece)
+	{
+		message_buffer.append(piece);
+	}
+
+	void append_piece(StringSlice piece)
+	{
+		message_buffer.append(piece.begin(), piece.end());
+	}
+
+	void append_piece(const std::string& piece)
+	{
+		message_buffer.append(piece);
+	}
+
+	void append_piece(long long piece)
+	{
+		message_buffer.append(std::to_string(piece));
+	}
+
+	void append_pieces()
+	{}
+
+	template <typename T, typename... REST>
+	void append_pieces(const T& piece, const REST& ... rest)
+	{
+		append_piece(piece);
+		append_pieces(rest...);
+	}
+
+
+public:
+	DiagnosticEngine()
+	{}
+
+	// Non-copyable, since the diagnostics point into the arena
+	DiagnosticEngine(const DiagnosticEngine& other) = delete;
+	DiagnosticEngine& operator=(const DiagnosticEngine& other) = delete;
+
+
+	/**
+	 * Reports an error about the given span of source text.
+	 */
+	template <typename... PIECES>
+	void error(DiagnosticKind kind, StringSlice span, const PIECES& ... message)
+	{
+		message_buffer.clear();
+		append_pieces(message...);
+
+		char* text = nullptr;
+		if (!message_buffer.empty()) {
+			text = arena.alloc_array<char>(message_buffer.size()).begin();
+			std::memcpy(text, message_buffer.data(), message_buffer.size());
+		}
+
+		Diagnostic d;
+		d.kind = kind;
+		d.span = span;
+		d.message = StringSlice(text, text + message_buffer.size());
+		Diagnostic* node = arena.alloc<Diagnostic>(d);
+
+		if (last != nullptr)
+			last->next = node;
+		else
+			first = node;
+		last = node;
+		++count;
+	}
+
+
+	/**
+	 * Reports copies of all of other's diagnostics, in order, e.g. to
+	 * merge in what was reported while parsing part of the input
+	 * separately.
+	 */
+	void append(const DiagnosticEngine& other)
+	{
+		for (const Diagnostic* d = other.first; d != nullptr; d = d->next)
+			error(d->kind, d->span, d->message);
+	}
+
+
+	size_t error_count() const
+	{
+		return count;
+	}
+
+	bool has_errors() const
+	{
+		return count > 0;
+	}
+
+	// First diagnostic in the order they were reported, or nullptr
+	const Diagnostic* begin() const
+	{
+		return first;
+	}
+
+
+	/**
+	 * Prints every diagnostic, with its line and column as found through
+	 * lines.
+	 */
+	void print(std::ostream& out, const char* file_path, const LineIndex& lines) const
+	{
+		for (const Diagnostic* d = first; d != nullptr; d = d->next) {
+			const SourcePosition pos = lines.position(d->span.begin());
+			const char* label = d->kind == LEX_ERROR ? "Lex error:" : "Parse error:";
+			out << "\x1b[31;1m" << label << "\033[0m \033[1m" << file_path << ":" << pos.line + 1 << ":" << pos.column << ":\033[0m\n    " << d->message << "\n\n";
+		}
+	}
+};
+
+
+#endif // DIAGNOSTICS_HPP
@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "diagnostics.hpp"
+#include "line_index.hpp"
+#include "string_slice.hpp"
+
+
+TEST_CASE("DiagnosticEngine collects errors in order", "[diagnostics]")
+{
+	const std::string source = "first\nsecond third\n";
+	const StringSlice first(source.data(), source.data() + 5);
+	const StringSlice third(source.data() + 13, source.data() + 18);
+
+	DiagnosticEngine diagnostics;
+	REQUIRE(!diagnostics.has_errors());
+	REQUIRE(diagnostics.begin() == nullptr);
+
+	diagnostics.error(PARSE_ERROR, first, "Unexpected '", first, "'.");
+	diagnostics.error(LEX_ERROR, third, std::string("Number "), 42, ", text ", third);
+	REQUIRE(diagnostics.has_errors());
+	REQUIRE(diagnostics.error_count() == 2);
+
+	const Diagnostic* d = diagnostics.begin();
+	REQUIRE(d->kind == PARSE_ERROR);
+	REQUIRE(d->span == "first");
+	REQUIRE(d->message == "Unexpected 'first'.");
+
+	d = d->next;
+	REQUIRE(d->kind == LEX_ERROR);
+	REQUIRE(d->span.begin() == third.begin());
+	REQUIRE(d->message == "Number 42, text third");
+	REQUIRE(d->next == nullptr);
+
+	// Lines are one-based when printed, columns zero-based
+	std::ostringstream out;
+	diagnostics.print(out, "file.rune", LineIndex(source));
+	REQUIRE(out.str().find("file.rune:1:0:") != std::string::npos);
+	REQUIRE(out.str().find("file.rune:2:7:") != std::string::npos);
+	REQUIRE(out.str().find("Number 42, text third") != std::string::npos);
+}
+
+
+TEST_CASE("DiagnosticEngine keeps its own copy of messages", "[diagnostics]")
+{
+	DiagnosticEngine diagnostics;
+	{
+		const std::string temp = "temporary message";
+		diagnostics.error(PARSE_ERROR, StringSlice(), temp);
+	}
+	diagnostics.error(PARSE_ERROR, StringSlice(), "another");
+
+	REQUIRE(diagnostics.begin()->message == "temporary message");
+	REQUIRE(diagnostics.begin()->next->message == "another");
+}
+
+
+TEST_CASE("DiagnosticEngine append", "[diagnostics]")
+{
+	const std::string source = "a b c";
+	DiagnosticEngine diagnostics;
+	diagnostics.error(LEX_ERROR, StringSlice(&source[0], &source[1]), "first");
+	{
+		DiagnosticEngine other;
+		other.error(PARSE_ERROR, StringSlice(&source[2], &source[3]), "second");
+		other.error(PARSE_ERROR, StringSlice(&source[4], &source[5]), "third");
+		diagnostics.append(other);
+	}
+
+	REQUIRE(diagnostics.error_count() == 3);
+	const Diagnostic* d = diagnostics.begin()->next;
+	REQUIRE(d->kind == PARSE_ERROR);
+	REQUIRE(d->span == "b");
+	REQUIRE(d->message == "second");
+	REQUIRE(d->next->message == "third");
+	REQUIRE(d->next->next == nullptr);
+}
\ No newline at end of file
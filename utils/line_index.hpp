@@ -0,0 +1,172 @@
+#ifndef LINE_INDEX_HPP
+#define LINE_INDEX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RUNE_LINE_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+/**
+ * Zero-based line and column of a position in a source file.  Columns
+ * are counted in bytes.
+ */
+struct SourcePosition {
+	unsigned int line = 0;
+	unsigned int column = 0;
+};
+
+
+/**
+ * Appends the offset (relative to base) of the byte after every newline
+ * in [begin, end) to starts.  Plain byte-at-a-time version.
+ */
+static inline void find_line_starts_scalar(const char* base, const char* begin, const char* end, std::vector<uint32_t>* starts)
+{
+	for (const char* itr = begin; itr < end; ++itr) {
+		if (*itr == '\n')
+			starts->push_back(static_cast<uint32_t>(itr + 1 - base));
+	}
+}
+
+
+/**
+ * Same as find_line_starts_scalar(), but checks 16 bytes at a time where
+ * SSE2 is available.
+ */
+static inline void find_line_starts(const char* base, const char* begin, const char* end, std::vector<uint32_t>* starts)
+{
+#ifdef RUNE_LINE_INDEX_SSE2
+	const __m128i nl = _mm_set1_epi8('\n');
+	while ((end - begin) >= 16) {
+		uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), nl));
+		while (mask != 0) {
+#ifdef _MSC_VER
+			unsigned long i;
+			_BitScanForward(&i, mask);
+#else
+			const unsigned int i = __builtin_ctz(mask);
+#endif
+			starts->push_back(static_cast<uint32_t>(begin + i + 1 - base));
+			mask &= mask - 1;
+		}
+		begin += 16;
+	}
+#endif
+
+	find_line_starts_scalar(base, begin, end, starts);
+}
+
+
+/**
+ * Maps byte positions in a source file to lines and columns.
+ *
+ * This is how positions are reported in diagnostics: nothing else tracks
+ * line or column numbers, it's all worked out from pointers into the
+ * source text after the fact.
+ *
+ * The table of line start offsets is built on the first query, so
+ * creating an index that ends up unused costs nothing.  Newlines are
+ * considered to be on the line that they end.
+ *
+ * Copies share the table, so e.g. an AST can take a copy of its token
+ * buffer's index without scanning the source again.  Building the table
+ * is synchronized and queries don't modify anything else, so an index and
+ * its copies can be queried from several threads at once.
+ *
+ * Like StringSlice, the index doesn't own the source text.
+ */
+class LineIndex
+{
+	struct Table {
+		std::once_flag built;
+		std::vector<uint32_t> line_starts; // Offset of the start of each line
+	};
+
+	const char* source = nullptr;
+	size_t source_length = 0;
+	std::shared_ptr<Table> table; // Shared between copies, nullptr if default constructed
+
+public:
+	LineIndex()
+	{}
+
+	LineIndex(const char* begin, const char* end): source {begin}, source_length {static_cast<size_t>(end - begin)}, table {std::make_shared<Table>()}
+	{
+		// Offsets are 32 bits
+		assert(source_length <= UINT32_MAX);
+	}
+
+	LineIndex(const std::string& text): LineIndex(text.data(), text.data() + text.size())
+	{}
+
+
+	// Number of lines in the source
+	size_t line_count() const
+	{
+		return line_starts().size();
+	}
+
+	// Whether p points into the indexed source (or just past its end)
+	bool contains(const char* p) const
+	{
+		return source != nullptr && p >= source && p <= (source + source_length);
+	}
+
+
+	/**
+	 * Returns the line that the byte at p is on.  p must be within the
+	 * source.
+	 */
+	unsigned int line_of(const char* p) const
+	{
+		assert(contains(p));
+		const std::vector<uint32_t>& starts = line_starts();
+
+		const uint32_t offset = static_cast<uint32_t>(p - source);
+		return static_cast<unsigned int>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1);
+	}
+
+	SourcePosition position(const char* p) const
+	{
+		SourcePosition pos;
+		pos.line = line_of(p);
+		pos.column = static_cast<unsigned int>(p - source) - line_starts()[pos.line];
+		return pos;
+	}
+
+
+private:
+	// The line start table, built on first use
+	const std::vector<uint32_t>& line_starts() const
+	{
+		if (table == nullptr) {
+			static const std::vector<uint32_t> no_source(1, 0);
+			return no_source;
+		}
+
+		Table& t = *table;
+		std::call_once(t.built, [this, &t]() {
+			// Guess at an average line length to avoid most regrowth
+			t.line_starts.reserve(source_length / 32 + 1);
+			t.line_starts.push_back(0);
+			find_line_starts(source, source, source + source_length, &t.line_starts);
+		});
+		return t.line_starts;
+	}
+};
+
+
+#endif // LINE_INDEX_HPP
@@ -0,0 +1,33 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "line_index.hpp"
+
+
+BENCHMARK("utils: LineIndex construction")
+{
+	const std::string input = generate_corpus(8 * 1024 * 1024, true);
+	std::vector<uint32_t> starts;
+
+	bench_report_throughput("scalar newline scan", input.size(), bench_best_time([&]() {
+		starts.clear();
+		find_line_starts_scalar(input.data(), input.data(), input.data() + input.size(), &starts);
+	}));
+
+	bench_report_throughput("find_line_starts()", input.size(), bench_best_time([&]() {
+		starts.clear();
+		find_line_starts(input.data(), input.data(), input.data() + input.size(), &starts);
+	}));
+
+	// Looking up every line start in order, which is the common pattern
+	const LineIndex lines(input);
+	const size_t line_count = lines.line_count();
+	bench_report_rate("in-order position() lookups", line_count, bench_best_time([&]() {
+		for (auto s: starts)
+			lines.position(input.data() + s);
+	}));
+}
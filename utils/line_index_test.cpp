@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "line_index.hpp"
+
+
+TEST_CASE("LineIndex positions", "[line_index]")
+{
+	const std::string input = "ab\ncde\n\n\xC3\xA9x\n";
+	const LineIndex lines(input);
+	const char* s = input.data();
+
+	REQUIRE(lines.line_count() == 5);
+
+	REQUIRE(lines.position(s).line == 0);
+	REQUIRE(lines.position(s).column == 0);
+
+	// Newlines are on the line that they end
+	REQUIRE(lines.position(s + 2).line == 0);
+	REQUIRE(lines.position(s + 2).column == 2);
+
+	REQUIRE(lines.position(s + 5).line == 1);
+	REQUIRE(lines.position(s + 5).column == 2);
+
+	REQUIRE(lines.position(s + 7).line == 2);
+	REQUIRE(lines.position(s + 7).column == 0);
+
+	// Columns are in bytes
+	REQUIRE(lines.position(s + 10).line == 3);
+	REQUIRE(lines.position(s + 10).column == 2);
+
+	// The end of the input is a valid position
+	REQUIRE(lines.position(s + input.size()).line == 4);
+	REQUIRE(lines.position(s + input.size()).column == 0);
+
+	// Out of order lookups
+	REQUIRE(lines.line_of(s + 1) == 0);
+	REQUIRE(lines.line_of(s + 9) == 3);
+	REQUIRE(lines.line_of(s + 4) == 1);
+}
+
+
+TEST_CASE("LineIndex empty input", "[line_index]")
+{
+	const std::string input = "";
+	const LineIndex lines(input);
+
+	REQUIRE(lines.line_count() == 1);
+	REQUIRE(lines.position(input.data()).line == 0);
+	REQUIRE(lines.position(input.data()).column == 0);
+}
+
+
+// The table is built by whichever thread asks first, and copies share it
+TEST_CASE("LineIndex concurrent queries", "[line_index]")
+{
+	std::string input;
+	for (int i = 0; i < 10000; ++i)
+		input += "line " + std::to_string(i) + "\n";
+	const LineIndex lines(input);
+	const LineIndex copy = lines;
+
+	std::vector<unsigned int> results(8, 0);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < results.size(); ++t) {
+		threads.emplace_back([&, t]() {
+			const LineIndex& index = (t % 2 == 0) ? lines : copy;
+			for (size_t i = 0; i < input.size(); i += 97)
+				results[t] += index.line_of(input.data() + i);
+		});
+	}
+	for (auto& thread: threads)
+		thread.join();
+
+	for (auto r: results)
+		REQUIRE(r == results[0]);
+	REQUIRE(copy.line_count() == 10001);
+	REQUIRE(lines.position(input.data() + input.find("line 5000")).line == 5000);
+}
+
+
+// The vectorized newline scan should find exactly the same line starts as
+// the scalar one, including near the ends of the 16-byte blocks.
+TEST_CASE("find_line_starts() matches scalar version", "[line_index]")
+{
+	std::srand(42);
+	for (int round = 0; round < 200; ++round) {
+		std::string input(std::rand() % 200, 'a');
+		for (auto& c: input) {
+			if (std::rand() % 7 == 0)
+				c = '\n';
+			else if (std::rand() % 11 == 0)
+				c = static_cast<char>(0x80 + std::rand() % 0x80);
+		}
+
+		for (size_t offset = 0; offset < 3 && offset <= input.size(); ++offset) {
+			std::vector<uint32_t> a;
+			std::vector<uint32_t> b;
+			find_line_starts_scalar(input.data(), input.data() + offset, input.data() + input.size(), &a);
+			find_line_starts(input.data(), input.data() + offset, input.data() + input.size(), &b);
+			REQUIRE(a == b);
+		}
+	}
+}
@@ -3,110 +3,377 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "slice.hpp"
 
+#ifdef MEMORY_ARENA_STATS
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define MEMORY_ARENA_MMAP
+#endif
+
 #ifdef _MSC_VER
 #define alignof(T) __alignof(T)
 #define alignas(T) __declspec(align(T))
+#define MEMORY_ARENA_NOINLINE __declspec(noinline)
+#else
+#define MEMORY_ARENA_NOINLINE __attribute__((noinline))
 #endif
 
+
+/**
+ * Whether a MemoryArena can skip destroying T even though T isn't
+ * trivially destructible.
+ *
+ * A class opts in by declaring a member typedef named
+ * arena_skips_destructor, and derived classes inherit that.  It's meant
+ * for class hierarchies with a virtual destructor whose objects don't
+ * actually own anything, like the AST nodes, so that the arena doesn't
+ * keep a destructor record for every one of them.
+ */
+template <typename T>
+class arena_skips_destructor
+{
+	template <typename U>
+	static std::true_type test(typename U::arena_skips_destructor*);
+	template <typename U>
+	static std::false_type test(...);
+
+public:
+	static const bool value = decltype(test<T>(nullptr))::value;
+};
+
+
+/**
+ * Where a MemoryArena gets its chunks from.
+ *
+ * ARENA_MMAP maps chunks straight from the OS, aligned to and rounded up
+ * to whole huge pages, and asks for them to be backed by transparent huge
+ * pages where that's supported.  That cuts TLB misses when an arena grows
+ * large.  On platforms without mmap it's the same as ARENA_HEAP.
+ */
+enum MemoryArenaBacking {
+	ARENA_HEAP,
+	ARENA_MMAP,
+};
+
+
 /**
  * A memory arena.
+ *
+ * Memory is handed out from a list of chunks by bumping a pointer.  The
+ * first chunk is MIN_CHUNK_SIZE bytes, and each new chunk is twice as
+ * large as the last (up to MAX_CHUNK_SIZE), so a large arena needs only
+ * a few dozen chunks.
+ *
+ * reset() frees everything allocated so far but keeps the chunks, so an
+ * arena can be reused (e.g. across compilations) without going back to
+ * the system allocator.  Likewise rewind() frees everything allocated
+ * since a mark(), e.g. to throw away the results of a speculative parse.
+ *
+ * Objects are constructed in place.  Those that aren't trivially
+ * destructible are recorded in a list, stored in the arena itself, and
+ * destroyed in reverse order when the arena is reset or destroyed.
+ * Trivially destructible types (plain structs, pointers, slices), and
+ * types marked with arena_skips_destructor, cost nothing extra.
+ *
+ * Building with MEMORY_ARENA_STATS defined (the RUNE_MEM_STATS CMake
+ * option) makes arenas record where their memory goes, for
+ * print_stats().  Without it none of that is compiled in.
  */
 template <size_t MIN_CHUNK_SIZE=4096>
 class MemoryArena
 {
+	static const size_t MAX_CHUNK_SIZE = 64 << 20;
+	static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
 	struct Chunk {
 		size_t size = 0;
-		size_t used = 0;
 		char* data = nullptr;
+#ifdef MEMORY_ARENA_STATS
+		size_t tail_waste = 0; // Space left unused when the arena moved on
+#endif
+	};
+
+	// An allocation whose elements need destroying
+	struct Destructor {
+		void (*destroy)(void* items, size_t count);
+		void* items;
+		size_t count;
+		Destructor* next;
 	};
 
 	std::vector<Chunk> chunks;
+	size_t current = 0; // Index of the chunk being allocated from
+	char* next = nullptr; // Next free byte in the current chunk
+	char* end = nullptr; // End of the current chunk
+	size_t next_chunk_size = MIN_CHUNK_SIZE;
+	MemoryArenaBacking backing = ARENA_HEAP;
+	Destructor* destructors = nullptr; // Most recent allocation first
+
+#ifdef MEMORY_ARENA_STATS
+	struct TypeStats {
+		size_t allocations = 0;
+		size_t items = 0;
+		size_t bytes = 0;
+	};
+
+	struct Stats {
+		std::map<std::type_index, TypeStats> types;
+		size_t padding = 0; // Bytes skipped to align allocations
+		size_t rewound = 0; // Bytes freed by rewind()
+	};
+
+	Stats stats;
+
+	template <typename T>
+	void record_alloc(size_t count, size_t padding)
+	{
+		TypeStats& t = stats.types[std::type_index(typeid(T))];
+		t.allocations += 1;
+		t.items += count;
+		t.bytes += sizeof(T) * count;
+		stats.padding += padding;
+	}
+
+	static std::string type_name(const std::type_index& type)
+	{
+#ifdef __GNUG__
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+		if (demangled != nullptr) {
+			std::string name = demangled;
+			std::free(demangled);
+			return name;
+		}
+#endif
+		return type.name();
+	}
+#endif
 
 
-	void add_chunk(size_t size)
+	Chunk new_chunk(size_t size)
 	{
 		Chunk c;
+#ifdef MEMORY_ARENA_MMAP
+		if (backing == ARENA_MMAP) {
+			// Map an extra huge page's worth so that the chunk can be
+			// aligned, and unmap what's left over on either side.
+			size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+			void* p = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				throw std::bad_alloc();
+
+			char* mapped = static_cast<char*>(p);
+			char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(mapped) + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+			if (aligned != mapped)
+				munmap(mapped, aligned - mapped);
+			if (aligned + size != mapped + size + HUGE_PAGE_SIZE)
+				munmap(aligned + size, (mapped + size + HUGE_PAGE_SIZE) - (aligned + size));
+#ifdef MADV_HUGEPAGE
+			madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+			c.size = size;
+			c.data = aligned;
+			return c;
+		}
+#endif
 		c.size = size;
-		if (size > 0) {
-			c.data = new char[size];
+		c.data = new char[size];
+		return c;
+	}
+
+	void free_chunk(const Chunk& c)
+	{
+#ifdef MEMORY_ARENA_MMAP
+		if (backing == ARENA_MMAP) {
+			munmap(c.data, c.size);
+			return;
 		}
-		chunks.push_back(c);
+#endif
+		delete[] c.data;
 	}
 
 	void clear_chunks()
 	{
-		for (auto& c: chunks) {
-			if (c.data != nullptr)
-				delete[] c.data;
-		}
+		run_destructors();
+		for (auto& c: chunks)
+			free_chunk(c);
 		chunks.clear();
 	}
 
+	void take(MemoryArena& other)
+	{
+		chunks = std::move(other.chunks);
+		current = other.current;
+		next = other.next;
+		end = other.end;
+		next_chunk_size = other.next_chunk_size;
+		backing = other.backing;
+		destructors = other.destructors;
+#ifdef MEMORY_ARENA_STATS
+		stats = std::move(other.stats);
+		other.stats = Stats();
+#endif
+
+		other.chunks.clear();
+		other.destructors = nullptr;
+		other.current = 0;
+		other.next = nullptr;
+		other.end = nullptr;
+		other.next_chunk_size = MIN_CHUNK_SIZE;
+	}
+
+	static char* align_up(char* p, size_t alignment)
+	{
+		const uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+		return p + ((alignment - (addr % alignment)) % alignment);
+	}
+
+
+	/**
+	 * Slow path of _alloc(): moves on to a chunk with room for bytes at
+	 * the given alignment, and allocates from it.
+	 *
+	 * After a reset() that's the next chunk already owned by the arena
+	 * that's large enough, and otherwise a new one.  Chunks that are
+	 * skipped stay around for the next reset().
+	 */
+	MEMORY_ARENA_NOINLINE char* alloc_from_next_chunk(size_t bytes, size_t alignment)
+	{
+		// Enough to fit the data however the chunk is aligned
+		const size_t min_size = bytes + alignment;
+
+#ifdef MEMORY_ARENA_STATS
+		if (next != nullptr)
+			chunks[current].tail_waste = end - next;
+#endif
+
+		const size_t first_unused = next == nullptr ? 0 : current + 1;
+		size_t i = first_unused;
+		while (i < chunks.size() && chunks[i].size < min_size)
+			++i;
+
+		// Either way, keep the chunks in the order they're used in
+		if (i < chunks.size()) {
+			std::swap(chunks[i], chunks[first_unused]);
+		}
+		else {
+			const size_t size = next_chunk_size > min_size ? next_chunk_size : min_size;
+			chunks.insert(chunks.begin() + first_unused, new_chunk(size));
+
+			if (next_chunk_size < MAX_CHUNK_SIZE)
+				next_chunk_size *= 2;
+		}
+		current = first_unused;
+
+		char* ptr = align_up(chunks[current].data, alignment);
+		next = ptr + bytes;
+		end = chunks[current].data + chunks[current].size;
+#ifdef MEMORY_ARENA_STATS
+		chunks[current].tail_waste = 0;
+#endif
+		return ptr;
+	}
+
+
 	/**
 	 * Allocates enough contiguous space for count items of type T, and
-	 * returns a pointer to the front of that space.
+	 * returns a pointer to the front of that space.  The items are left
+	 * unconstructed.
 	 */
 	template <typename T>
 	T* _alloc(size_t count)
 	{
-		// Figure out how much padding we need between elements for proper
-		// memory alignment if we put them in an array.
-		const auto array_pad = (alignof(T) - (sizeof(T) % alignof(T))) % alignof(T);
-
-		// Total needed bytes for the requested array of data
-		const auto needed_bytes = (sizeof(T) * count) + (array_pad * (count - 1));
-
-		// Figure out how much padding we need at the beginning to put the
-		// first element in the right place for memory alignment.
-		const auto mem_addr = reinterpret_cast<uintptr_t>(chunks.back().data + chunks.back().used);
-		const auto begin_pad = (alignof(T) - (mem_addr % alignof(T))) % alignof(T);
-
-		// Get the number of bytes left in the current chunk
-		const auto available_bytes = chunks.back().size - chunks.back().used;
-
-		// If we don't have enough space in this chunk, then we need to create
-		// a new chunk.
-		if ((begin_pad + needed_bytes) > available_bytes) {
-			// Calculate the minimum needed bytes to guarantee that we can
-			// accommodate properlyaligned data.
-			const auto min_needed_bytes = needed_bytes + alignof(T);
-
-			// Make sure we don't get a chunk smaller than MIN_CHUNK_SIZE
-			const size_t new_chunk_size = min_needed_bytes > MIN_CHUNK_SIZE ? min_needed_bytes : MIN_CHUNK_SIZE;
-
-			// Create the new chunk, and then recurse for DRY purposes.
-			// TODO: if we break things up differently, we could perhaps
-			// avoid the redundant work caused by recursing while still
-			// being DRY.  Super low priority, though, unless this somehow
-			// turns out to be a performance bottleneck.
-			add_chunk(new_chunk_size);
-			return _alloc<T>(count);
+		// sizeof() is always a multiple of alignof(), so an array needs no
+		// padding between elements.
+		const size_t bytes = sizeof(T) * count;
+
+		char* ptr = align_up(next, alignof(T));
+		if ((bytes + (ptr - next)) > static_cast<size_t>(end - next)) {
+			ptr = alloc_from_next_chunk(bytes, alignof(T));
+#ifdef MEMORY_ARENA_STATS
+			record_alloc<T>(count, ptr - chunks[current].data);
+#endif
 		}
-
-		// Otherwise, proceed in getting the pointer and recording how much
-		// of the chunk we used.
-		T* ptr = reinterpret_cast<T*>(chunks.back().data + chunks.back().used + begin_pad);
-		for (unsigned int i=0; i < count; ++i) {
-			new(ptr+i) T();
+		else {
+#ifdef MEMORY_ARENA_STATS
+			record_alloc<T>(count, ptr - next);
+#endif
+			next = ptr + bytes;
 		}
-		chunks.back().used += begin_pad + needed_bytes;
 
-		// Ta da!
-		return ptr;
+		return reinterpret_cast<T*>(ptr);
 	}
 
 
-public:
-	MemoryArena()
+	template <typename T>
+	static void destroy_items(void* items, size_t count)
+	{
+		T* t = static_cast<T*>(items);
+		for (size_t i = count; i > 0; --i)
+			t[i - 1].~T();
+	}
+
+	// Records constructed items that need destroying later.  Trivially
+	// destructible types, and those marked arena_skips_destructor, are
+	// sorted out at compile time and skip this.
+	template <typename T>
+	void register_destructor(T* items, size_t count, std::false_type)
+	{
+		Destructor* d = _alloc<Destructor>(1);
+		d->destroy = &destroy_items<T>;
+		d->items = items;
+		d->count = count;
+		d->next = destructors;
+		destructors = d;
+	}
+
+	template <typename T>
+	void register_destructor(T*, size_t, std::true_type)
+	{}
+
+	template <typename T>
+	void register_destructor(T* items, size_t count)
 	{
-		// Start with a single chunk of size zero,
-		// to simplify the logic in _alloc()
-		add_chunk(0);
+		register_destructor(items, count, std::integral_constant<bool, std::is_trivially_destructible<T>::value || arena_skips_destructor<T>::value>());
 	}
+
+	// Runs destructors registered after until, most recent first
+	void run_destructors(Destructor* until = nullptr)
+	{
+		while (destructors != until) {
+			Destructor* d = destructors;
+			destructors = d->next;
+			d->destroy(d->items, d->count);
+		}
+	}
+
+
+public:
+	MemoryArena()
+	{}
+
+	explicit MemoryArena(MemoryArenaBacking backing): backing {backing}
+	{}
+
 	~MemoryArena()
 	{
 		clear_chunks();
@@ -120,11 +387,12 @@ public:
 #ifdef _MSC_VER
 	MemoryArena(MemoryArena& other)
 	{
-		chunks = std::move(other.chunks);
+		take(other);
 	}
 	MemoryArena& operator=(MemoryArena& other)
 	{
-		chunks = std::move(other.chunks);
+		clear_chunks();
+		take(other);
 		return *this;
 	}
 #else
@@ -133,42 +401,200 @@ public:
 #endif
 	MemoryArena(MemoryArena&& other)
 	{
-		chunks = std::move(other.chunks);
+		take(other);
 	}
 	MemoryArena& operator=(MemoryArena&& other)
 	{
-		chunks = std::move(other.chunks);
+		clear_chunks();
+		take(other);
 		return *this;
 	}
 
 
 	/**
-	 * Allocates space for a single element of type T and returns a
-	 * raw pointer to that space.
+	 * Destroys and frees everything allocated from the arena, keeping the
+	 * chunks to allocate from again.
+	 */
+	void reset()
+	{
+		run_destructors();
+#ifdef MEMORY_ARENA_STATS
+		stats = Stats();
+		for (auto& c: chunks)
+			c.tail_waste = 0;
+#endif
+		current = 0;
+		if (chunks.empty()) {
+			next = nullptr;
+			end = nullptr;
+		}
+		else {
+			next = chunks[0].data;
+			end = chunks[0].data + chunks[0].size;
+		}
+	}
+
+
+	/**
+	 * A point in the arena's allocations to rewind() back to.
+	 */
+	class Checkpoint
+	{
+		friend class MemoryArena;
+
+		size_t chunk = 0;
+		char* next = nullptr;
+		Destructor* destructors = nullptr;
+	};
+
+
+	/**
+	 * Returns a checkpoint of the arena's current state.
+	 */
+	Checkpoint mark() const
+	{
+		Checkpoint c;
+		c.chunk = current;
+		c.next = next;
+		c.destructors = destructors;
+		return c;
+	}
+
+
+	/**
+	 * Destroys and frees everything allocated since the given checkpoint
+	 * was taken.  Later allocations reuse the space, and any chunks added
+	 * in the meantime are kept for reuse as well.
+	 *
+	 * The checkpoint must not predate a reset(), or a rewind() to an
+	 * earlier checkpoint.
+	 */
+	void rewind(const Checkpoint& c)
+	{
+		run_destructors(c.destructors);
+#ifdef MEMORY_ARENA_STATS
+		const size_t used = bytes_used();
+#endif
+		current = c.chunk;
+		next = c.next;
+		end = next == nullptr ? nullptr : chunks[current].data + chunks[current].size;
+#ifdef MEMORY_ARENA_STATS
+		stats.rewound += used - bytes_used();
+#endif
+	}
+
+
+	/**
+	 * Returns the number of bytes allocated from the arena so far,
+	 * including alignment padding and the space left unused at the end
+	 * of full chunks.
+	 */
+	size_t bytes_used() const
+	{
+		if (next == nullptr)
+			return 0;
+
+		size_t total = next - chunks[current].data;
+		for (size_t i = 0; i < current; ++i)
+			total += chunks[i].size;
+		return total;
+	}
+
+
+	/**
+	 * Returns the total size of the arena's chunks, in bytes.
+	 */
+	size_t capacity() const
+	{
+		size_t total = 0;
+		for (const auto& c: chunks)
+			total += c.size;
+		return total;
+	}
+
+
+	size_t chunk_count() const
+	{
+		return chunks.size();
+	}
+
+
+#ifdef MEMORY_ARENA_STATS
+	/**
+	 * Prints what the arena's memory has gone to since it was created or
+	 * last reset(): allocations and bytes per type, alignment padding,
+	 * and the chunks with the space wasted at the end of each.
+	 *
+	 * Allocations that were later rewound are still counted per type.
+	 */
+	void print_stats(std::ostream& out) const
+	{
+		std::multimap<size_t, std::pair<std::string, TypeStats>, std::greater<size_t>> by_bytes;
+		for (const auto& t: stats.types)
+			by_bytes.insert(std::make_pair(t.second.bytes, std::make_pair(type_name(t.first), t.second)));
+
+		out << "    " << bytes_used() << " bytes used of " << capacity() << " in " << chunks.size() << " chunks\n";
+		out << "    " << stats.padding << " bytes of alignment padding, " << stats.rewound << " bytes rewound\n";
+		for (const auto& t: by_bytes) {
+			const TypeStats& ts = t.second.second;
+			out << "    " << ts.bytes << " bytes, " << ts.allocations << (ts.allocations == 1 ? " allocation" : " allocations");
+			if (ts.items != ts.allocations)
+				out << " (" << ts.items << " items)";
+			out << ": " << t.second.first << "\n";
+		}
+
+		for (size_t i = 0; i < chunks.size(); ++i) {
+			out << "    chunk " << i << ": " << chunks[i].size << " bytes";
+			if (next != nullptr && i < current)
+				out << ", " << chunks[i].tail_waste << " wasted at the end";
+			else if (next != nullptr && i == current)
+				out << ", " << (end - next) << " free";
+			else
+				out << ", unused";
+			out << "\n";
+		}
+	}
+#endif
+
+
+	/**
+	 * Constructs a T in the arena from the given arguments, and returns a
+	 * raw pointer to it.
+	 */
+	template <typename T, typename... ARGS>
+	T* emplace(ARGS&&... args)
+	{
+		T* ptr = new(_alloc<T>(1)) T(std::forward<ARGS>(args)...);
+		register_destructor(ptr, 1);
+		return ptr;
+	}
+
+
+	/**
+	 * Allocates a single value-initialized element of type T and returns
+	 * a raw pointer to it.
 	 */
 	template <typename T>
 	T* alloc()
 	{
-		return _alloc<T>(1);
+		return emplace<T>();
 	}
 
 
 	/**
-	 * Allocates space for a single element of type T, initializes it with
-	 * init, and returns a raw pointer to that space.
+	 * Allocates a single element of type T, copy-constructed from init,
+	 * and returns a raw pointer to it.
 	 */
 	template <typename T>
 	T* alloc(const T& init)
 	{
-		auto ptr = _alloc<T>(1);
-		*ptr = init;
-		return ptr;
+		return emplace<T>(init);
 	}
 
 
 	/**
-	 * Allocates enough space for count elements of type T, and returns
-	 * a Slice to that space.
+	 * Allocates count value-initialized elements of type T, and returns
+	 * a Slice to them.
 	 */
 	template <typename T>
 	Slice<T> alloc_array(size_t count)
@@ -176,27 +602,29 @@ public:
 		if (count <= 0)
 			return Slice<T>();
 
-		return Slice<T>(_alloc<T>(count), count);
+		T* ptr = _alloc<T>(count);
+		for (size_t i = 0; i < count; ++i)
+			new(ptr + i) T();
+		register_destructor(ptr, count);
+
+		return Slice<T>(ptr, count);
 	}
 
 
 	/**
-	 * Allocates space to hold the contents of the iters, and copys the
-	 * iter's contents over.  Returns a Slice to that memory.
+	 * Allocates an array holding a copy of the contents of the iters,
+	 * copy-constructed in place.  Returns a Slice to that memory.
 	 */
-	template <typename ITER, typename T=typename ITER::value_type>
+	template <typename ITER, typename T=typename std::iterator_traits<ITER>::value_type>
 	Slice<T> alloc_from_iters(ITER begin, ITER end)
 	{
 		const size_t size = std::distance(begin, end);
 		if (size <= 0)
 			return Slice<T>();
 
-		auto ptr = _alloc<T>(size);
-
-		for (size_t i = 0; i < size; ++i) {
-			ptr[i] = *begin;
-			++begin;
-		}
+		T* ptr = _alloc<T>(size);
+		std::uninitialized_copy(begin, end, ptr);
+		register_destructor(ptr, size);
 
 		return Slice<T>(ptr, size);
 	}
@@ -0,0 +1,118 @@
+#include "bench.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "memory_arena.hpp"
+
+
+namespace {
+
+// The arena as it was before chunks grew geometrically: fixed-size
+// chunks, and a slow path that recurses after adding a chunk.  Kept here
+// to compare against.
+template <size_t MIN_CHUNK_SIZE=4096>
+class FixedChunkArena
+{
+	struct Chunk {
+		size_t size = 0;
+		size_t used = 0;
+		char* data = nullptr;
+	};
+
+	std::vector<Chunk> chunks;
+
+	void add_chunk(size_t size)
+	{
+		Chunk c;
+		c.size = size;
+		if (size > 0)
+			c.data = new char[size];
+		chunks.push_back(c);
+	}
+
+public:
+	FixedChunkArena()
+	{
+		add_chunk(0);
+	}
+
+	~FixedChunkArena()
+	{
+		for (auto& c: chunks)
+			delete[] c.data;
+	}
+
+	template <typename T>
+	T* alloc()
+	{
+		const auto needed_bytes = sizeof(T);
+		const auto mem_addr = reinterpret_cast<uintptr_t>(chunks.back().data + chunks.back().used);
+		const auto begin_pad = (alignof(T) - (mem_addr % alignof(T))) % alignof(T);
+		const auto available_bytes = chunks.back().size - chunks.back().used;
+
+		if ((begin_pad + needed_bytes) > available_bytes) {
+			const auto min_needed_bytes = needed_bytes + alignof(T);
+			add_chunk(min_needed_bytes > MIN_CHUNK_SIZE ? min_needed_bytes : MIN_CHUNK_SIZE);
+			return alloc<T>();
+		}
+
+		T* ptr = reinterpret_cast<T*>(chunks.back().data + chunks.back().used + begin_pad);
+		new(ptr) T();
+		chunks.back().used += begin_pad + needed_bytes;
+		return ptr;
+	}
+};
+
+
+// About the size of a typical AST node
+struct Node {
+	void* a;
+	void* b;
+	uint64_t c;
+	uint32_t d;
+};
+
+} // namespace
+
+
+BENCHMARK("utils: MemoryArena allocation")
+{
+	const size_t count = 4 * 1000 * 1000;
+	std::printf("    %lu allocations of %lu bytes\n", (unsigned long)count, (unsigned long)sizeof(Node));
+
+	bench_report_rate("fixed 4KB chunks", count, bench_best_time([&]() {
+		FixedChunkArena<> arena;
+		for (size_t i = 0; i < count; ++i)
+			arena.alloc<Node>()->d = i;
+	}));
+
+	bench_report_rate("geometric chunks", count, bench_best_time([&]() {
+		MemoryArena<> arena;
+		for (size_t i = 0; i < count; ++i)
+			arena.alloc<Node>()->d = i;
+	}));
+
+	bench_report_rate("geometric chunks, mmap", count, bench_best_time([&]() {
+		MemoryArena<> arena(ARENA_MMAP);
+		for (size_t i = 0; i < count; ++i)
+			arena.alloc<Node>()->d = i;
+	}));
+
+	// Reusing one arena, like across many compilations
+	MemoryArena<> heap_arena;
+	bench_report_rate("geometric chunks, reset()", count, bench_best_time([&]() {
+		heap_arena.reset();
+		for (size_t i = 0; i < count; ++i)
+			heap_arena.alloc<Node>()->d = i;
+	}));
+
+	MemoryArena<> mmap_arena(ARENA_MMAP);
+	bench_report_rate("geometric chunks, mmap, reset()", count, bench_best_time([&]() {
+		mmap_arena.reset();
+		for (size_t i = 0; i < count; ++i)
+			mmap_arena.alloc<Node>()->d = i;
+	}));
+	std::printf("    %lu chunks, %lu bytes\n", (unsigned long)heap_arena.chunk_count(), (unsigned long)heap_arena.capacity());
+}
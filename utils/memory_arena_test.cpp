@@ -3,6 +3,10 @@
 #include <cstdint>
 #include <vector>
 #include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
 #include "slice.hpp"
 
 #include "memory_arena.hpp"
@@ -103,4 +107,315 @@ TEST_CASE("Memory alignment requirements", "[memory_arena]")
 	REQUIRE((a % alignof(SomeType)) == 0);
 	REQUIRE((b % alignof(SomeType)) == 0);
 	REQUIRE((c % alignof(SomeType)) == 0);
-}
\ No newline at end of file
+}
+
+
+// Make sure chunks grow geometrically instead of staying at the minimum
+TEST_CASE("Geometric chunk growth", "[memory_arena]")
+{
+	MemoryArena<64> arena;
+
+	for (int i = 0; i < 100000; ++i)
+		arena.alloc<int64_t>(i);
+
+	REQUIRE(arena.capacity() >= 100000 * sizeof(int64_t));
+	REQUIRE(arena.chunk_count() < 20);
+}
+
+
+// Make sure allocations larger than any chunk so far still work
+TEST_CASE("Allocations larger than a chunk", "[memory_arena]")
+{
+	MemoryArena<16> arena;
+
+	int32_t* a = arena.alloc<int32_t>(1);
+	Slice<int32_t> big = arena.alloc_array<int32_t>(1000);
+	int32_t* b = arena.alloc<int32_t>(2);
+
+	big[999] = 42;
+	REQUIRE(*a == 1);
+	REQUIRE(*b == 2);
+	REQUIRE(big[0] == 0);
+	REQUIRE(big[999] == 42);
+}
+
+
+// Make sure reset() reuses the chunks it already has
+TEST_CASE("reset() reuses chunks", "[memory_arena]")
+{
+	MemoryArena<64> arena;
+
+	int32_t* first = arena.alloc<int32_t>(1);
+	for (int i = 0; i < 10000; ++i)
+		arena.alloc<int32_t>(i);
+	const size_t capacity = arena.capacity();
+	const size_t chunk_count = arena.chunk_count();
+
+	arena.reset();
+	REQUIRE(arena.alloc<int32_t>(7) == first);
+	for (int i = 0; i < 10000; ++i)
+		arena.alloc<int32_t>(i);
+
+	REQUIRE(arena.capacity() == capacity);
+	REQUIRE(arena.chunk_count() == chunk_count);
+
+	// A large allocation after a reset skips the chunks too small for it,
+	// which are still there for later.
+	arena.reset();
+	Slice<int32_t> big = arena.alloc_array<int32_t>(5000);
+	big[4999] = 3;
+	REQUIRE(arena.alloc<int32_t>(4) != nullptr);
+	REQUIRE(arena.chunk_count() == chunk_count);
+}
+
+
+// Make sure mmap-backed arenas work like heap-backed ones
+TEST_CASE("mmap backing", "[memory_arena]")
+{
+	MemoryArena<> arena(ARENA_MMAP);
+
+	int64_t* a = arena.alloc<int64_t>(1);
+	uintptr_t s = reinterpret_cast<uintptr_t>(arena.alloc<SomeType>());
+	Slice<char> big = arena.alloc_array<char>(5 << 20);
+	big[(5 << 20) - 1] = 'x';
+
+	REQUIRE(*a == 1);
+	REQUIRE((s % alignof(SomeType)) == 0);
+	REQUIRE(big[(5 << 20) - 1] == 'x');
+
+	arena.reset();
+	REQUIRE(arena.alloc<int64_t>(2) == a);
+}
+
+
+// Make sure moving an arena moves its allocation state too
+TEST_CASE("Moving arenas", "[memory_arena]")
+{
+	MemoryArena<16> a;
+	int32_t* x = a.alloc<int32_t>(1);
+	int32_t* y = a.alloc<int32_t>(2);
+
+	MemoryArena<16> b(std::move(a));
+	int32_t* z = b.alloc<int32_t>(3);
+
+	REQUIRE((x+1) == y);
+	REQUIRE((y+1) == z);
+	REQUIRE(a.chunk_count() == 0);
+	REQUIRE(a.alloc<int32_t>(4) != nullptr);
+}
+
+// Counts its live instances, and records the order it's destroyed in
+struct Tracked {
+	static int live;
+	static std::vector<int> destroyed;
+	int id;
+
+	Tracked(): id {-1}
+	{
+		++live;
+	}
+	explicit Tracked(int id): id {id}
+	{
+		++live;
+	}
+	Tracked(const Tracked& other): id {other.id}
+	{
+		++live;
+	}
+	~Tracked()
+	{
+		--live;
+		destroyed.push_back(id);
+	}
+};
+
+int Tracked::live = 0;
+std::vector<int> Tracked::destroyed;
+
+
+// Make sure emplace() forwards its arguments, including move-only ones
+TEST_CASE("emplace() forwarding", "[memory_arena]")
+{
+	struct Owner {
+		std::unique_ptr<int> value;
+		std::string name;
+
+		Owner(std::unique_ptr<int> value, const std::string& name): value {std::move(value)}, name {name}
+		{}
+	};
+
+	MemoryArena<> arena;
+	Owner* o = arena.emplace<Owner>(std::unique_ptr<int>(new int(5)), "five");
+
+	REQUIRE(*o->value == 5);
+	REQUIRE(o->name == "five");
+}
+
+
+// Make sure destructors run, most recent allocation first, when the arena
+// is destroyed or reset
+TEST_CASE("Destructors", "[memory_arena]")
+{
+	Tracked::live = 0;
+	Tracked::destroyed.clear();
+
+	{
+		MemoryArena<64> arena;
+		arena.emplace<Tracked>(1);
+		arena.alloc_array<Tracked>(2);
+		std::vector<Tracked> v {Tracked(3), Tracked(4)};
+		arena.alloc_from_iters(v.begin(), v.end());
+		REQUIRE(Tracked::live == 7);
+
+		Tracked::destroyed.clear();
+		arena.reset();
+		REQUIRE(Tracked::live == 2);
+		const std::vector<int> expected {4, 3, -1, -1, 1};
+		REQUIRE(Tracked::destroyed == expected);
+
+		Tracked::destroyed.clear();
+		arena.emplace<Tracked>(5);
+		arena.alloc(Tracked(6));
+	}
+
+	// The temporary and the vector go first, then the arena
+	REQUIRE(Tracked::live == 0);
+	const std::vector<int> expected {6, 3, 4, 6, 5};
+	REQUIRE(Tracked::destroyed == expected);
+}
+
+
+// Make sure trivially destructible types don't take any space for
+// destructor bookkeeping, while others do
+TEST_CASE("Destructor bookkeeping", "[memory_arena]")
+{
+	MemoryArena<> arena;
+
+	int64_t* a = arena.alloc<int64_t>();
+	int64_t* b = arena.alloc<int64_t>();
+	REQUIRE((a+1) == b);
+
+	Tracked* c = arena.alloc<Tracked>();
+	Tracked* d = arena.alloc<Tracked>();
+	REQUIRE((c+1) != d);
+}
+
+
+struct Unowning {
+	typedef void arena_skips_destructor;
+
+	int* target = nullptr;
+	virtual ~Unowning() {}
+};
+
+struct DerivedUnowning: Unowning {
+	~DerivedUnowning() { *target = 1; }
+};
+
+
+// Make sure types marked arena_skips_destructor, and types derived from
+// them, are neither recorded nor destroyed
+TEST_CASE("Skipping destructors", "[memory_arena]")
+{
+	REQUIRE(arena_skips_destructor<Unowning>::value);
+	REQUIRE(arena_skips_destructor<DerivedUnowning>::value);
+	REQUIRE_FALSE(arena_skips_destructor<Tracked>::value);
+
+	int destroyed = 0;
+	{
+		MemoryArena<> arena;
+		DerivedUnowning* a = arena.alloc<DerivedUnowning>();
+		DerivedUnowning* b = arena.alloc<DerivedUnowning>();
+		REQUIRE((a+1) == b);
+		a->target = &destroyed;
+		b->target = &destroyed;
+	}
+	REQUIRE(destroyed == 0);
+}
+
+// Make sure rewind() frees exactly what was allocated since the mark
+TEST_CASE("mark() and rewind()", "[memory_arena]")
+{
+	MemoryArena<64> arena;
+
+	int32_t* a = arena.alloc<int32_t>(1);
+	const auto m = arena.mark();
+	const size_t used = arena.bytes_used();
+
+	int32_t* b = arena.alloc<int32_t>(2);
+	for (int i = 0; i < 1000; ++i)
+		arena.alloc<int32_t>(i);
+	const size_t chunk_count = arena.chunk_count();
+	REQUIRE(arena.bytes_used() > used);
+
+	arena.rewind(m);
+	REQUIRE(arena.bytes_used() == used);
+	REQUIRE(*a == 1);
+
+	// The space is reused, chunks and all
+	REQUIRE(arena.alloc<int32_t>(3) == b);
+	for (int i = 0; i < 1000; ++i)
+		arena.alloc<int32_t>(i);
+	REQUIRE(arena.chunk_count() == chunk_count);
+}
+
+
+// Make sure rewind() runs the destructors of what it frees, and only those
+TEST_CASE("rewind() destructors", "[memory_arena]")
+{
+	Tracked::live = 0;
+	Tracked::destroyed.clear();
+
+	MemoryArena<64> arena;
+	arena.emplace<Tracked>(1);
+	const auto outer = arena.mark();
+	arena.emplace<Tracked>(2);
+	const auto inner = arena.mark();
+	arena.emplace<Tracked>(3);
+	arena.alloc_array<Tracked>(100);
+
+	arena.rewind(inner);
+	REQUIRE(Tracked::live == 2);
+	REQUIRE(Tracked::destroyed.back() == 3);
+
+	Tracked::destroyed.clear();
+	arena.rewind(outer);
+	REQUIRE(Tracked::live == 1);
+	REQUIRE(Tracked::destroyed == std::vector<int> {2});
+}
+
+
+// Make sure a mark taken before anything was allocated works
+TEST_CASE("rewind() to an empty arena", "[memory_arena]")
+{
+	MemoryArena<16> arena;
+	const auto m = arena.mark();
+
+	int64_t* a = arena.alloc<int64_t>(1);
+	arena.alloc_array<int64_t>(10);
+	arena.rewind(m);
+
+	REQUIRE(arena.bytes_used() == 0);
+	REQUIRE(arena.alloc<int64_t>(2) == a);
+}
+
+
+#ifdef MEMORY_ARENA_STATS
+// Make sure allocations, padding and chunk waste all get recorded
+TEST_CASE("Arena statistics", "[memory_arena]")
+{
+	MemoryArena<64> arena;
+	arena.alloc<char>();
+	arena.alloc<int64_t>();
+	arena.alloc_array<int64_t>(10);
+
+	std::ostringstream out;
+	arena.print_stats(out);
+	const std::string stats = out.str();
+
+	REQUIRE(stats.find("7 bytes of alignment padding") != std::string::npos);
+	REQUIRE(stats.find("88 bytes, 2 allocations (11 items): ") != std::string::npos);
+	REQUIRE(stats.find("1 bytes, 1 allocation: char") != std::string::npos);
+	REQUIRE(stats.find("chunk 0: 64 bytes, 48 wasted at the end") != std::string::npos);
+}
+#endif
\ No newline at end of file
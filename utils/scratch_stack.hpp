@@ -0,0 +1,153 @@
+#ifndef SCRATCH_STACK_HPP
+#define SCRATCH_STACK_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "memory_arena.hpp"
+#include "slice.hpp"
+
+
+/**
+ * Reusable scratch space for building lists whose final size isn't known
+ * up front, before copying them into an arena.
+ *
+ * Lists are built with ScratchList, and nest like a stack: a list started
+ * while another is being built has to be committed (or destroyed) before
+ * the outer one gets any more elements.  That's exactly the shape of a
+ * recursive descent parser, where e.g. a scope's statement list is put on
+ * hold while a nested scope builds its own.
+ *
+ * The space only ever grows, so once it's big enough for the deepest
+ * nesting, building lists costs no allocations at all.
+ */
+class ScratchStack
+{
+	template <typename T>
+	friend class ScratchList;
+
+	std::vector<char> buffer;
+	size_t top = 0; // End of the used part of buffer
+
+	// Reserves bytes at the top of the stack, aligned for alignment,
+	// and returns their offset.
+	size_t push(size_t bytes, size_t alignment)
+	{
+		const size_t offset = (top + alignment - 1) / alignment * alignment;
+		if ((offset + bytes) > buffer.size())
+			buffer.resize((offset + bytes) > buffer.size() * 2 ? (offset + bytes) : buffer.size() * 2);
+		top = offset + bytes;
+		return offset;
+	}
+
+public:
+	ScratchStack()
+	{}
+
+	ScratchStack(const ScratchStack& other) = delete;
+	ScratchStack& operator=(const ScratchStack& other) = delete;
+
+	// Bytes in use by lists being built
+	size_t size() const
+	{
+		return top;
+	}
+
+	// Bytes of space currently held
+	size_t capacity() const
+	{
+		return buffer.size();
+	}
+};
+
+
+/**
+ * A list being built on a ScratchStack.  Elements are pushed onto it, and
+ * once it's complete commit() copies them into an arena as a Slice.
+ *
+ * If the list is destroyed without being committed (e.g. while unwinding
+ * from an error), its elements are simply dropped.
+ *
+ * Only for trivially copyable types, since elements are moved around as
+ * raw bytes and never destroyed.
+ */
+template <typename T>
+class ScratchList
+{
+	static_assert(std::is_trivially_copyable<T>::value, "ScratchList elements must be trivially copyable");
+
+	ScratchStack& stack;
+	size_t begin; // Offset of the first element in the stack's buffer
+	size_t count = 0;
+	size_t restore_top; // Top of the stack before this list started
+
+	T* items()
+	{
+		return reinterpret_cast<T*>(stack.buffer.data() + begin);
+	}
+
+public:
+	explicit ScratchList(ScratchStack& stack): stack {stack}, restore_top {stack.top}
+	{
+		begin = stack.push(0, alignof(T));
+	}
+
+	~ScratchList()
+	{
+		stack.top = restore_top;
+	}
+
+	ScratchList(const ScratchList& other) = delete;
+	ScratchList& operator=(const ScratchList& other) = delete;
+
+
+	void push_back(const T& item)
+	{
+		// Anything nested should be finished by now
+		assert(stack.top == begin + (count * sizeof(T)));
+
+		// Copied first, in case item is in the buffer and it moves
+		const T copy = item;
+		const size_t offset = stack.push(sizeof(T), alignof(T));
+		std::memcpy(stack.buffer.data() + offset, &copy, sizeof(T));
+		++count;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	// Valid until the next push_back()
+	T& operator[](size_t i)
+	{
+		assert(i < count);
+		return items()[i];
+	}
+
+
+	/**
+	 * Copies the elements into the arena, and returns them as a Slice.
+	 * The list is empty afterwards.
+	 */
+	template <size_t MIN_CHUNK_SIZE>
+	Slice<T> commit(MemoryArena<MIN_CHUNK_SIZE>& arena)
+	{
+		assert(stack.top == begin + (count * sizeof(T)));
+
+		Slice<T> s = arena.alloc_from_iters(items(), items() + count);
+		count = 0;
+		stack.top = begin;
+		return s;
+	}
+};
+
+#endif // SCRATCH_STACK_HPP
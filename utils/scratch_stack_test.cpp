@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "memory_arena.hpp"
+#include "scratch_stack.hpp"
+#include "slice.hpp"
+
+
+// Make sure a list comes out of the arena with its elements in order
+TEST_CASE("ScratchList commit", "[scratch_stack]")
+{
+	ScratchStack stack;
+	MemoryArena<> arena;
+
+	ScratchList<int32_t> list(stack);
+	for (int32_t i = 0; i < 1000; ++i)
+		list.push_back(i);
+	REQUIRE(list.size() == 1000);
+
+	Slice<int32_t> s = list.commit(arena);
+	REQUIRE(s.size() == 1000);
+	for (int32_t i = 0; i < 1000; ++i)
+		REQUIRE(s[i] == i);
+
+	REQUIRE(list.empty());
+	REQUIRE(stack.size() == 0);
+	REQUIRE(list.commit(arena).size() == 0);
+}
+
+
+// Make sure nested lists of different types don't disturb each other
+TEST_CASE("Nested ScratchLists", "[scratch_stack]")
+{
+	ScratchStack stack;
+	MemoryArena<> arena;
+
+	ScratchList<char> outer(stack);
+	outer.push_back('a');
+	Slice<int64_t> inner_slice;
+	{
+		ScratchList<int64_t> inner(stack);
+		inner.push_back(1);
+		{
+			ScratchList<char> innermost(stack);
+			innermost.push_back('x');
+			REQUIRE(innermost.commit(arena).size() == 1);
+		}
+		inner.push_back(2);
+		inner_slice = inner.commit(arena);
+	}
+	outer.push_back('b');
+
+	Slice<char> outer_slice = outer.commit(arena);
+	REQUIRE(outer_slice.size() == 2);
+	REQUIRE(outer_slice[0] == 'a');
+	REQUIRE(outer_slice[1] == 'b');
+	REQUIRE(inner_slice.size() == 2);
+	REQUIRE(inner_slice[0] == 1);
+	REQUIRE(inner_slice[1] == 2);
+	REQUIRE((reinterpret_cast<uintptr_t>(inner_slice.begin()) % alignof(int64_t)) == 0);
+}
+
+
+// Make sure lists abandoned while unwinding are dropped, and the space
+// is reused
+TEST_CASE("Abandoned ScratchLists", "[scratch_stack]")
+{
+	ScratchStack stack;
+	MemoryArena<> arena;
+
+	ScratchList<int32_t> outer(stack);
+	outer.push_back(1);
+	try {
+		ScratchList<int32_t> inner(stack);
+		for (int32_t i = 0; i < 100; ++i)
+			inner.push_back(i);
+		throw std::runtime_error("abandon");
+	}
+	catch (const std::runtime_error&) {}
+	outer.push_back(2);
+
+	const size_t capacity = stack.capacity();
+	Slice<int32_t> s = outer.commit(arena);
+	REQUIRE(s.size() == 2);
+	REQUIRE(s[1] == 2);
+
+	{
+		ScratchList<int32_t> again(stack);
+		for (int32_t i = 0; i < 100; ++i)
+			again.push_back(i);
+	}
+	REQUIRE(stack.capacity() == capacity);
+}
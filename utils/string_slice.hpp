@@ -4,9 +4,97 @@
 
 #include <iostream>
 #include <string>
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
 
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+
+// Multiplies a and b to 128 bits and folds the halves together.  The
+// basic mixing step of hash_bytes().
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+	return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	uint64_t hi;
+	const uint64_t lo = _umul128(a, b, &hi);
+	return lo ^ hi;
+#else
+	// Put together the high half from 32-bit pieces
+	const uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+	const uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+	const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	return (a * b) ^ (hi_hi + (hi_lo >> 32) + (cross >> 32));
+#endif
+}
+
+
+static inline uint64_t hash_read64(const char* p)
+{
+	uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+}
+
+static inline uint64_t hash_read32(const char* p)
+{
+	uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+}
+
+
+/**
+ * Hashes a run of bytes, sixteen at a time, in the style of wyhash.  Never
+ * allocates, and short strings (the common case for identifiers) take
+ * just a couple of loads and multiplies.  Not suitable for anything
+ * security related.
+ */
+static inline uint64_t hash_bytes(const char* data, size_t length)
+{
+	const uint64_t k0 = 0xA0761D6478BD642Full;
+	const uint64_t k1 = 0xE7037ED1A0B428DBull;
+
+	uint64_t h = k0;
+	uint64_t a = 0;
+	uint64_t b = 0;
+
+	// The tail is read with fixed-size loads that may overlap, rather
+	// than copying it out byte by byte.
+	if (length <= 16) {
+		if (length >= 8) {
+			a = hash_read64(data);
+			b = hash_read64(data + length - 8);
+		}
+		else if (length >= 4) {
+			a = hash_read32(data);
+			b = hash_read32(data + length - 4);
+		}
+		else if (length > 0) {
+			const unsigned char* u = reinterpret_cast<const unsigned char*>(data);
+			a = (static_cast<uint64_t>(u[0]) << 16) | (static_cast<uint64_t>(u[length / 2]) << 8) | u[length - 1];
+		}
+	}
+	else {
+		const char* end = data + length;
+		while ((end - data) > 16) {
+			h = hash_mix(hash_read64(data) ^ k1, hash_read64(data + 8) ^ h);
+			data += 16;
+		}
+		a = hash_read64(end - 16);
+		b = hash_read64(end - 8);
+	}
+
+	return hash_mix(k1 ^ length, hash_mix(a ^ k1, b ^ h));
+}
+
+
 /**
  * A non-owning view into part of a std::string.
  */
@@ -80,16 +168,7 @@ struct StringSlice {
 	bool operator==(const StringSlice &other) const
 	{
 		const auto len = length();
-		const auto other_len = other.length();
-		if (len != other_len)
-			return false;
-
-		for (unsigned int i = 0; i < len; ++i) {
-			if (iter[i] != other.iter[i])
-				return false;
-		}
-
-		return true;
+		return len == other.length() && (len == 0 || std::memcmp(iter, other.iter, len) == 0);
 	}
 
 	bool operator!=(const StringSlice &other) const
@@ -101,17 +180,7 @@ struct StringSlice {
 	bool operator==(const std::string &other) const
 	{
 		const auto len = length();
-		const auto other_len = other.length();
-		if (len != other_len)
-			return false;
-
-		auto other_iter = other.begin();
-		for (unsigned int i = 0; i < len; ++i) {
-			if (iter[i] != other_iter[i])
-				return false;
-		}
-
-		return true;
+		return len == other.length() && (len == 0 || std::memcmp(iter, other.data(), len) == 0);
 	}
 
 	bool operator!=(const std::string &other) const
@@ -123,17 +192,7 @@ struct StringSlice {
 	bool operator==(const char* const str) const
 	{
 		const auto len = length();
-
-		unsigned int i = 0;
-		for (; i < len; ++i) {
-			if (iter[i] != str[i] || str[i] == '\0')
-				return false;
-		}
-
-		if (str[i] != '\0')
-			return false;
-
-		return true;
+		return std::strlen(str) == len && (len == 0 || std::memcmp(iter, str, len) == 0);
 	}
 
 	bool operator!=(const char* const str) const
@@ -168,9 +227,7 @@ struct hash<StringSlice> {
 
 	result_type operator()(argument_type const& s) const
 	{
-		// TODO: something more efficient that avoids allocating
-		// a std::string.
-		return std::hash<std::string>()(s.to_string());
+		return static_cast<result_type>(hash_bytes(s.begin(), s.length()));
 	}
 };
 }
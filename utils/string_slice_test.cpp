@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <string>
+#include <unordered_set>
+
+#include "string_slice.hpp"
+
+
+TEST_CASE("StringSlice comparisons", "[string_slice]")
+{
+	const std::string text = "hello hello help";
+	const StringSlice a(text.data(), text.data() + 5);
+	const StringSlice b(text.data() + 6, text.data() + 11);
+	const StringSlice c(text.data() + 12, text.data() + 16);
+	const StringSlice empty;
+
+	REQUIRE(a == b);
+	REQUIRE(a != c);
+	REQUIRE(a != StringSlice(text.data(), text.data() + 4));
+	REQUIRE(empty == StringSlice(text.data(), text.data()));
+
+	REQUIRE(a == std::string("hello"));
+	REQUIRE(a != std::string("hell"));
+	REQUIRE(a != std::string("hello!"));
+	REQUIRE(empty == std::string());
+
+	REQUIRE(a == "hello");
+	REQUIRE(a != "hell");
+	REQUIRE(a != "hello!");
+	REQUIRE(c != "hel");
+	REQUIRE(empty == "");
+	REQUIRE(empty != "x");
+
+	// Embedded nulls
+	const std::string nulls("ab\0cd", 5);
+	const StringSlice n(nulls.begin(), nulls.end());
+	REQUIRE(n == nulls);
+	REQUIRE(n != "ab");
+	REQUIRE(n != std::string("ab\0ce", 5));
+}
+
+
+TEST_CASE("StringSlice hashing", "[string_slice]")
+{
+	std::hash<StringSlice> hash;
+
+	// Equal slices hash equally, wherever they are
+	const std::string text = "some_long_identifier_name some_long_identifier_name";
+	const StringSlice a(text.data(), text.data() + 25);
+	const StringSlice b(text.data() + 26, text.data() + 51);
+	REQUIRE(a == b);
+	REQUIRE(hash(a) == hash(b));
+	REQUIRE(hash(StringSlice()) == hash(StringSlice(text.data(), text.data())));
+
+	// Every length up to a few words with small differences anywhere,
+	// and all the short strings, give distinct hashes.
+	std::unordered_set<std::string> strings;
+	for (size_t len = 0; len < 40; ++len) {
+		std::string s(len, 'x');
+		strings.insert(s);
+		for (size_t i = 0; i < len; ++i) {
+			s[i] = 'y';
+			strings.insert(s);
+			s[i] = 'x';
+		}
+	}
+
+	// Every byte string of length one and two
+	for (int i = 0; i < 256; ++i) {
+		strings.insert(std::string(1, static_cast<char>(i)));
+		for (int j = 0; j < 256; ++j)
+			strings.insert(std::string {static_cast<char>(i), static_cast<char>(j)});
+	}
+
+	std::unordered_set<size_t> hashes;
+	for (const auto& s: strings)
+		hashes.insert(hash(StringSlice(s.begin(), s.end())));
+	REQUIRE(hashes.size() == strings.size());
+}
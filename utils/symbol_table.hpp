@@ -0,0 +1,189 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "memory_arena.hpp"
+#include "string_slice.hpp"
+
+
+/**
+ * The symbol ID of nothing: tokens that aren't identifiers or operators,
+ * and names that haven't been filled in.  Real symbol IDs start at 1.
+ */
+static const uint32_t NO_SYMBOL = 0;
+
+
+/**
+ * Interns strings, handing out a dense 32-bit ID for each distinct one.
+ *
+ * The lexer interns every identifier and operator as it goes, so that
+ * everything downstream can compare and look up names by ID rather than
+ * hashing and comparing text again.  Since IDs are dense, lookup tables
+ * keyed by them can just be arrays indexed by ID.
+ *
+ * The table keeps its own copy of the text, so IDs stay valid after the
+ * source they were interned from is gone.
+ *
+ * Not thread safe: while one thread is interning, no other thread may
+ * use the same table at all.
+ */
+class SymbolTable
+{
+	MemoryArena<> text_store;
+	// A hash table entry.  The hash is kept alongside the ID so that most
+	// mismatches are caught without looking at the symbol's text.
+	struct Slot {
+		uint32_t hash = 0;
+		uint32_t id = NO_SYMBOL; // NO_SYMBOL for empty slots
+	};
+
+	std::vector<StringSlice> texts; // Text of each symbol, indexed by ID
+	std::vector<Slot> slots; // Open-addressed hash table
+
+public:
+	SymbolTable()
+	{
+		texts.push_back(StringSlice());
+		slots.resize(1024);
+	}
+
+	SymbolTable(const SymbolTable& other) = delete;
+	SymbolTable& operator=(const SymbolTable& other) = delete;
+
+
+	/**
+	 * Returns the ID of the given text, adding it to the table first if
+	 * it isn't already there.
+	 */
+	uint32_t intern(StringSlice text)
+	{
+		const uint32_t hash = hash_text(text);
+
+		size_t slot = find_slot(text, hash);
+		if (slots[slot].id != NO_SYMBOL)
+			return slots[slot].id;
+
+		// Not found, so add it
+		const uint32_t id = static_cast<uint32_t>(texts.size());
+		const size_t length = text.length();
+		char* copy = length > 0 ? text_store.alloc_array<char>(length).begin() : nullptr;
+		if (length > 0)
+			std::memcpy(copy, text.begin(), length);
+		texts.push_back(StringSlice(copy, copy + length));
+
+		// Keep the load factor at or below one half
+		if ((texts.size() * 2) > slots.size()) {
+			grow();
+			slot = find_slot(text, hash);
+		}
+		slots[slot].hash = hash;
+		slots[slot].id = id;
+
+		return id;
+	}
+
+
+	/**
+	 * Returns the ID of the given text, or NO_SYMBOL if it hasn't been
+	 * interned.
+	 */
+	uint32_t find(StringSlice text) const
+	{
+		return slots[find_slot(text, hash_text(text))].id;
+	}
+
+
+	// The text of a symbol
+	StringSlice text(uint32_t id) const
+	{
+		assert(id < texts.size());
+		return texts[id];
+	}
+
+
+	// One more than the largest ID handed out so far, i.e. the size an
+	// array indexed by ID needs to be.
+	size_t size() const
+	{
+		return texts.size();
+	}
+
+
+	// Where the symbols' text is stored
+	const MemoryArena<>& text_arena() const
+	{
+		return text_store;
+	}
+
+
+private:
+	static uint32_t hash_text(StringSlice text)
+	{
+		return static_cast<uint32_t>(hash_bytes(text.begin(), text.length()));
+	}
+
+	// Returns the slot holding the given text, or the empty slot where it
+	// would go.
+	size_t find_slot(StringSlice text, uint32_t hash) const
+	{
+		const size_t mask = slots.size() - 1;
+		const size_t length = text.length();
+
+		for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+			const uint32_t id = slots[slot].id;
+			if (id == NO_SYMBOL)
+				return slot;
+
+			if (slots[slot].hash == hash && texts[id].length() == length && (length == 0 || std::memcmp(texts[id].begin(), text.begin(), length) == 0))
+				return slot;
+		}
+	}
+
+	// Doubles the number of slots
+	void grow()
+	{
+		std::vector<Slot> new_slots(slots.size() * 2);
+		const size_t mask = new_slots.size() - 1;
+
+		for (const auto& entry: slots) {
+			if (entry.id == NO_SYMBOL)
+				continue;
+
+			size_t slot = entry.hash & mask;
+			while (new_slots[slot].id != NO_SYMBOL)
+				slot = (slot + 1) & mask;
+			new_slots[slot] = entry;
+		}
+
+		slots.swap(new_slots);
+	}
+};
+
+
+/**
+ * The process-wide symbol table that the lexer interns into.
+ */
+inline SymbolTable& global_symbols()
+{
+	static SymbolTable symbols;
+	return symbols;
+}
+
+
+/**
+ * The decoded contents of string literals with escape sequences, interned
+ * the same way as symbols.  Kept apart from global_symbols() so that arrays indexed by
+ * symbol ID don't grow with the number of distinct string literals.
+ */
+inline SymbolTable& global_strings()
+{
+	static SymbolTable strings;
+	return strings;
+}
+
+
+#endif // SYMBOL_TABLE_HPP
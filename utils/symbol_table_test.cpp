@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "symbol_table.hpp"
+
+
+TEST_CASE("SymbolTable interning", "[symbol_table]")
+{
+	SymbolTable symbols;
+	REQUIRE(symbols.size() == 1);
+
+	const uint32_t a = symbols.intern("foo");
+	const uint32_t b = symbols.intern("bar");
+	REQUIRE(a != NO_SYMBOL);
+	REQUIRE(b != NO_SYMBOL);
+	REQUIRE(a != b);
+	REQUIRE(symbols.size() == 3);
+
+	// Same text, same ID, wherever the text lives
+	const std::string foo = "a foo b";
+	REQUIRE(symbols.intern(StringSlice(foo.data() + 2, foo.data() + 5)) == a);
+	REQUIRE(symbols.intern("bar") == b);
+	REQUIRE(symbols.size() == 3);
+
+	REQUIRE(symbols.text(a) == "foo");
+	REQUIRE(symbols.text(b) == "bar");
+
+	REQUIRE(symbols.find("foo") == a);
+	REQUIRE(symbols.find("fo") == NO_SYMBOL);
+	REQUIRE(symbols.find("food") == NO_SYMBOL);
+}
+
+
+TEST_CASE("SymbolTable keeps its own copy of the text", "[symbol_table]")
+{
+	SymbolTable symbols;
+	uint32_t id;
+	{
+		const std::string temp = "temporary";
+		id = symbols.intern(StringSlice(temp.begin(), temp.end()));
+	}
+	REQUIRE(symbols.text(id) == "temporary");
+}
+
+
+TEST_CASE("SymbolTable IDs are dense and survive growth", "[symbol_table]")
+{
+	SymbolTable symbols;
+	std::vector<std::string> names;
+	for (int i = 0; i < 20000; ++i)
+		names.push_back("name_" + std::to_string(i));
+
+	for (size_t i = 0; i < names.size(); ++i)
+		REQUIRE(symbols.intern(StringSlice(names[i].begin(), names[i].end())) == i + 1);
+
+	for (size_t i = 0; i < names.size(); ++i) {
+		REQUIRE(symbols.find(StringSlice(names[i].begin(), names[i].end())) == i + 1);
+		REQUIRE(symbols.text(i + 1) == names[i]);
+	}
+}
@@ -0,0 +1,171 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * A minimal fixed-size thread pool for data-parallel work.
+ *
+ * The only operation is run(), which calls a function for every index in
+ * [0, task_count) spread across the pool's threads and the calling thread,
+ * and returns once they're all done.  Tasks are handed out one index at a
+ * time, so uneven task sizes balance out.
+ *
+ * Concurrent calls to run() from different threads are serialized.  A
+ * task that calls run() on the same pool (say, a per-file task that lexes
+ * a large file in parallel) gets the inner tasks run on its own thread,
+ * rather than waiting on the pool it's part of forever.  Tasks must not
+ * throw.
+ */
+class ThreadPool
+{
+	std::vector<std::thread> threads;
+
+	std::mutex run_mutex; // Only one run() at a time
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+
+	// The current job, protected by mutex
+	const std::function<void(size_t)>* job = nullptr;
+	size_t job_size = 0;
+	size_t job_generation = 0;
+	size_t workers_busy = 0;
+	bool shutting_down = false;
+
+	std::atomic<size_t> next_task {0};
+
+public:
+	/**
+	 * Creates a pool that runs tasks on thread_count threads in total,
+	 * including the thread that calls run().  Zero means one per hardware
+	 * thread.
+	 */
+	explicit ThreadPool(unsigned int thread_count = 0)
+	{
+		if (thread_count == 0)
+			thread_count = std::thread::hardware_concurrency();
+
+		for (unsigned int i = 1; i < thread_count; ++i)
+			threads.emplace_back([this]() { worker(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			shutting_down = true;
+		}
+		work_ready.notify_all();
+
+		for (auto& t: threads)
+			t.join();
+	}
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+
+	// Total number of threads that run tasks, including the caller's
+	size_t size() const
+	{
+		return threads.size() + 1;
+	}
+
+
+	/**
+	 * Calls task(i) for every i in [0, task_count), in parallel, and waits
+	 * for all of them to finish.
+	 */
+	void run(size_t task_count, const std::function<void(size_t)>& task)
+	{
+		if (threads.empty() || task_count <= 1 || current_pool() == this) {
+			for (size_t i = 0; i < task_count; ++i)
+				task(i);
+			return;
+		}
+
+		std::lock_guard<std::mutex> run_lock(run_mutex);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &task;
+			job_size = task_count;
+			next_task = 0;
+			workers_busy = threads.size();
+			++job_generation;
+		}
+		work_ready.notify_all();
+
+		do_tasks(task, task_count);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		work_done.wait(lock, [this]() { return workers_busy == 0; });
+		job = nullptr;
+	}
+
+
+private:
+	// The pool whose tasks the calling thread is running, if any
+	static const ThreadPool*& current_pool()
+	{
+		static thread_local const ThreadPool* pool = nullptr;
+		return pool;
+	}
+
+	void do_tasks(const std::function<void(size_t)>& task, size_t task_count)
+	{
+		const ThreadPool* outer = current_pool();
+		current_pool() = this;
+		for (size_t i = next_task++; i < task_count; i = next_task++)
+			task(i);
+		current_pool() = outer;
+	}
+
+	void worker()
+	{
+		size_t seen_generation = 0;
+
+		while (true) {
+			const std::function<void(size_t)>* my_job;
+			size_t my_size;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				work_ready.wait(lock, [&]() { return shutting_down || job_generation != seen_generation; });
+				if (shutting_down)
+					return;
+				seen_generation = job_generation;
+				my_job = job;
+				my_size = job_size;
+			}
+
+			do_tasks(*my_job, my_size);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--workers_busy;
+			}
+			work_done.notify_one();
+		}
+	}
+};
+
+
+/**
+ * A process-wide pool with one thread per hardware thread, created on
+ * first use.
+ */
+inline ThreadPool& default_thread_pool()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+
+TEST_CASE("ThreadPool size", "[thread_pool]")
+{
+	ThreadPool one(1);
+	REQUIRE(one.size() == 1);
+
+	ThreadPool four(4);
+	REQUIRE(four.size() == 4);
+
+	ThreadPool hardware;
+	REQUIRE(hardware.size() >= 1);
+}
+
+
+// Make sure every task runs exactly once, for a range of task counts,
+// and that the pool can be reused from one run() to the next
+TEST_CASE("ThreadPool runs every task once", "[thread_pool]")
+{
+	ThreadPool pool(4);
+
+	const size_t task_counts[] = {0, 1, 2, 3, 4, 5, 100, 10000};
+	for (auto count: task_counts) {
+		INFO("task count " << count);
+		std::vector<std::atomic<int>> runs(count);
+		for (auto& r: runs)
+			r = 0;
+
+		pool.run(count, [&](size_t i) { ++runs[i]; });
+
+		for (size_t i = 0; i < count; ++i)
+			REQUIRE(runs[i] == 1);
+	}
+}
+
+
+// Make sure the tasks really are spread over the pool's threads.  Each
+// task waits for all of them to have started, so this only finishes if
+// four run at once.
+TEST_CASE("ThreadPool runs tasks in parallel", "[thread_pool]")
+{
+	ThreadPool pool(4);
+	std::atomic<int> started {0};
+	std::mutex mutex;
+	std::set<std::thread::id> thread_ids;
+
+	pool.run(4, [&](size_t) {
+		++started;
+		while (started < 4)
+			std::this_thread::yield();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		thread_ids.insert(std::this_thread::get_id());
+	});
+
+	REQUIRE(thread_ids.size() == 4);
+}
+
+
+// Make sure run() calls from several threads at once each get all of
+// their own tasks run
+TEST_CASE("ThreadPool concurrent run() calls", "[thread_pool]")
+{
+	ThreadPool pool(4);
+	std::atomic<size_t> totals[4];
+
+	std::vector<std::thread> callers;
+	for (size_t c = 0; c < 4; ++c) {
+		totals[c] = 0;
+		callers.emplace_back([&, c]() {
+			for (int rep = 0; rep < 50; ++rep)
+				pool.run(100, [&](size_t i) { totals[c] += i; });
+		});
+	}
+	for (auto& t: callers)
+		t.join();
+
+	for (size_t c = 0; c < 4; ++c)
+		REQUIRE(totals[c] == static_cast<size_t>(50 * 4950));
+}
+
+
+// A task that runs more tasks on its own pool gets them run on its own
+// thread, instead of deadlocking
+TEST_CASE("ThreadPool nested run() calls", "[thread_pool]")
+{
+	ThreadPool pool(4);
+	std::atomic<size_t> total {0};
+	std::atomic<bool> moved_threads {false};
+
+	pool.run(8, [&](size_t) {
+		const std::thread::id outer = std::this_thread::get_id();
+		pool.run(10, [&](size_t i) {
+			if (std::this_thread::get_id() != outer)
+				moved_threads = true;
+			total += i;
+		});
+	});
+
+	REQUIRE(total == static_cast<size_t>(8 * 45));
+	REQUIRE(!moved_threads);
+}
@@ -2,6 +2,8 @@
 #define TOKENS_HPP
 
 
+#include <cstdint>
+
 #include "string_slice.hpp"
 
 enum TokenType {
@@ -82,11 +84,20 @@ enum TokenType {
 	K_TYPE,
 };
 
+/**
+ * The decoded value of a literal token.
+ */
+union TokenValue {
+	uint64_t integer; // INTEGER_LIT
+	double real; // FLOAT_LIT
+	uint32_t string; // STRING_LIT: ID of the decoded contents in global_strings(), or NO_SYMBOL if they're the token text
+};
+
 struct Token {
 	TokenType type = UNKNOWN;
-	unsigned int line = 0; // Line of the source file the token starts on (newline tokens are considered to be the last token of the line that they end)
-	unsigned int column = 0; // Column of the line the token starts on
-	StringSlice text; // A reference to the text of the token
+	uint32_t symbol = 0; // Symbol ID of identifiers and operators (see SymbolTable), otherwise NO_SYMBOL
+	StringSlice text; // A reference to the text of the token.  Its line and column can be found with a LineIndex.
+	TokenValue value = {0}; // Value of literals, zero for everything else
 };
 
 